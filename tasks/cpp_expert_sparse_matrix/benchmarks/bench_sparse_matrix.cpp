@@ -0,0 +1,170 @@
+#include "sparse_matrix.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+// Hand-rolled microbenchmark driver: no external dependencies, JSON on
+// stdout so runs can be diffed across commits. Each benchmark is warmed
+// up, then timed over several repetitions; we report the minimum (least
+// noisy on a shared box) and the median nanoseconds per operation.
+namespace {
+
+inline std::uint64_t nowNs() {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+// Defeats dead-code elimination without perturbing the measured loop.
+template <class T>
+inline void doNotOptimize(const T& value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+bool firstRecord = true;
+
+// Runs `fn` (which performs `opsPerCall` logical operations) enough times
+// to fill ~50ms per repetition, over kWarmup + kRepetitions passes, and
+// emits one JSON record.
+template <class Fn>
+void runBenchmark(const std::string& name, std::size_t opsPerCall, Fn&& fn) {
+  constexpr int kWarmup = 2;
+  constexpr int kRepetitions = 5;
+  constexpr std::uint64_t kTargetNsPerRep = 50'000'000;
+
+  // Calibrate: how many calls fit in one repetition.
+  std::uint64_t calls = 1;
+  for (;;) {
+    const std::uint64_t start = nowNs();
+    for (std::uint64_t i = 0; i < calls; ++i) {
+      fn();
+    }
+    const std::uint64_t elapsed = nowNs() - start;
+    if (elapsed >= kTargetNsPerRep / 4 || calls >= (1u << 20)) {
+      if (elapsed < kTargetNsPerRep && elapsed > 0) {
+        calls = calls * kTargetNsPerRep / elapsed + 1;
+      }
+      break;
+    }
+    calls *= 4;
+  }
+
+  std::vector<double> nsPerOp;
+  for (int rep = 0; rep < kWarmup + kRepetitions; ++rep) {
+    const std::uint64_t start = nowNs();
+    for (std::uint64_t i = 0; i < calls; ++i) {
+      fn();
+    }
+    const std::uint64_t elapsed = nowNs() - start;
+    if (rep >= kWarmup) {
+      nsPerOp.push_back(static_cast<double>(elapsed) /
+                        (static_cast<double>(calls) * opsPerCall));
+    }
+  }
+  std::sort(nsPerOp.begin(), nsPerOp.end());
+  const double minNs = nsPerOp.front();
+  const double medianNs = nsPerOp[nsPerOp.size() / 2];
+
+  std::printf("%s  {\"name\": \"%s\", \"calls_per_rep\": %llu, "
+              "\"ops_per_call\": %zu, \"ns_per_op_min\": %.2f, "
+              "\"ns_per_op_median\": %.2f, \"ops_per_sec\": %.0f}",
+              firstRecord ? "" : ",\n", name.c_str(),
+              static_cast<unsigned long long>(calls), opsPerCall, minNs,
+              medianNs, 1e9 / minNs);
+  firstRecord = false;
+  std::fflush(stdout);
+}
+
+// Uniformly random matrix with roughly rows*cols*density stored entries.
+SparseMatrix makeRandomMatrix(std::size_t rows, std::size_t cols,
+                              double density, std::uint64_t seed) {
+  std::mt19937_64 rng(seed);
+  std::uniform_int_distribution<std::size_t> rowDist(0, rows - 1);
+  std::uniform_int_distribution<std::size_t> colDist(0, cols - 1);
+  std::uniform_real_distribution<double> valDist(-1.0, 1.0);
+  const auto target = static_cast<std::size_t>(
+      static_cast<double>(rows) * static_cast<double>(cols) * density);
+  std::vector<SparseMatrix::Triplet> triplets;
+  triplets.reserve(target);
+  for (std::size_t i = 0; i < target; ++i) {
+    triplets.push_back({rowDist(rng), colDist(rng), valDist(rng)});
+  }
+  return SparseMatrix::fromTriplets(rows, cols, std::move(triplets));
+}
+
+std::string label(const char* op, std::size_t n, double density) {
+  char buf[96];
+  std::snprintf(buf, sizeof(buf), "%s/n=%zu/density=%g", op, n, density);
+  return buf;
+}
+
+void benchConstruction(std::size_t n, double density) {
+  std::mt19937_64 rng(42);
+  std::uniform_int_distribution<std::size_t> idx(0, n - 1);
+  std::uniform_real_distribution<double> valDist(-1.0, 1.0);
+  const auto target = static_cast<std::size_t>(
+      static_cast<double>(n) * static_cast<double>(n) * density);
+  std::vector<SparseMatrix::Triplet> triplets;
+  triplets.reserve(target);
+  for (std::size_t i = 0; i < target; ++i) {
+    triplets.push_back({idx(rng), idx(rng), valDist(rng)});
+  }
+  // ops_per_call = nnz so the figure reads as ns per ingested triplet.
+  runBenchmark(label("fromTriplets", n, density), triplets.size(), [&]() {
+    auto copy = triplets;
+    auto m = SparseMatrix::fromTriplets(n, n, std::move(copy));
+    doNotOptimize(m.nnz());
+  });
+}
+
+void benchSpmv(std::size_t n, double density) {
+  const SparseMatrix m = makeRandomMatrix(n, n, density, 1);
+  std::vector<double> x(n, 1.0);
+  std::vector<double> y(n, 0.0);
+  runBenchmark(label("spmv", n, density), m.nnz(), [&]() {
+    m.spmv(x, y);
+    doNotOptimize(y[0]);
+  });
+}
+
+void benchSpgemm(std::size_t n, double density) {
+  const SparseMatrix a = makeRandomMatrix(n, n, density, 2);
+  const SparseMatrix b = makeRandomMatrix(n, n, density, 3);
+  runBenchmark(label("multiply", n, density), a.nnz(), [&]() {
+    auto c = a.multiply(b);
+    doNotOptimize(c.nnz());
+  });
+}
+
+void benchTranspose(std::size_t n, double density) {
+  const SparseMatrix m = makeRandomMatrix(n, n, density, 4);
+  runBenchmark(label("transpose", n, density), m.nnz(), [&]() {
+    auto t = m.transpose();
+    doNotOptimize(t.nnz());
+  });
+}
+
+}  // namespace
+
+int main() {
+  std::printf("[\n");
+  for (std::size_t n : {1000, 4000}) {
+    for (double density : {0.001, 0.01}) {
+      benchConstruction(n, density);
+      benchSpmv(n, density);
+      benchTranspose(n, density);
+    }
+  }
+  // SpGEMM output grows with density^2; keep the sweep affordable.
+  benchSpgemm(1000, 0.001);
+  benchSpgemm(1000, 0.01);
+  benchSpgemm(4000, 0.001);
+  std::printf("\n]\n");
+  return 0;
+}
@@ -0,0 +1,14 @@
+#!/usr/bin/env bash
+set -euo pipefail
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+WORKSPACE="$ROOT/workspace"
+BIN="$ROOT/benchmarks/sparse_matrix_bench"
+
+g++ -std=c++20 -O2 -Wall -Wextra -pedantic \
+  "$WORKSPACE/sparse_matrix.cpp" \
+  "$ROOT/benchmarks/bench_sparse_matrix.cpp" \
+  -I"$WORKSPACE" \
+  -o "$BIN"
+
+# Emits a JSON array on stdout; redirect to a file to diff across commits.
+"$BIN"
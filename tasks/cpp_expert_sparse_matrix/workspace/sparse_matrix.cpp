@@ -1,37 +1,2108 @@
 #include "sparse_matrix.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
 
-struct SparseMatrix::Impl {};
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-SparseMatrix::SparseMatrix(std::size_t, std::size_t) : impl_(nullptr) {
-  throw std::logic_error("not implemented");
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define SPARSE_MATRIX_X86 1
+#endif
+
+namespace {
+
+// Shape classes for the specialized SpMV inner loops. Classified once
+// per structure change from measured row statistics (see
+// classifySpmvShape) and cached on the Impl alongside the other derived
+// companions.
+enum class SpmvShape : std::uint8_t { kGeneric, kShortRow, kBanded };
+
+}  // namespace
+
+template <class T, class Index>
+struct BasicSparseMatrix<T, Index>::Impl {
+  std::atomic<std::size_t> refs{1};  // copy-on-write sharing count
+  std::size_t rows = 0;
+  std::size_t cols = 0;
+  std::vector<Index> row_ptr;  // rows + 1 entries
+  std::vector<Index> col_idx;  // nnz entries, sorted within each row
+  std::vector<T> values;       // nnz entries, parallel to col_idx
+
+  // Buffered writes: set() appends here (kept sorted by row, col and
+  // unique) instead of splicing the CSR arrays; a value of zero marks a
+  // deletion. delta_adjust tracks the net nnz effect so nnz() stays O(1).
+  struct Delta {
+    std::size_t row;
+    std::size_t col;
+    T value;
+    bool in_csr;  // whether the CSR arrays hold this coordinate
+  };
+  static constexpr std::size_t kCompactThreshold = 4096;
+  std::vector<Delta> delta;
+  std::ptrdiff_t delta_adjust = 0;
+
+  static std::ptrdiff_t deltaContribution(const Delta& d) noexcept {
+    if (d.in_csr) {
+      return d.value == T{} ? -1 : 0;
+    }
+    return d.value != T{} ? 1 : 0;
+  }
+
+  // Folds the delta log into the CSR arrays in one merge pass over both;
+  // a mapped matrix lands in owned vectors and releases its mapping.
+  void compactLog() {
+    if (delta.empty()) {
+      return;
+    }
+    const Index* rp = rowPtr();
+    const Index* ci = colIdx();
+    const T* vv = vals();
+
+    std::vector<Index> newRowPtr(rows + 1, 0);
+    std::vector<Index> newColIdx;
+    std::vector<T> newValues;
+    newColIdx.reserve(count() + delta.size());
+    newValues.reserve(count() + delta.size());
+
+    std::size_t d = 0;
+    for (std::size_t r = 0; r < rows; ++r) {
+      std::size_t k = rp[r];
+      const std::size_t kEnd = rp[r + 1];
+      while (k < kEnd || (d < delta.size() && delta[d].row == r)) {
+        const bool haveLog = d < delta.size() && delta[d].row == r;
+        if (haveLog && (k == kEnd || delta[d].col <= ci[k])) {
+          if (k < kEnd && delta[d].col == ci[k]) {
+            ++k;  // the log entry overrides this CSR entry
+          }
+          if (delta[d].value != T{}) {
+            newColIdx.push_back(static_cast<Index>(delta[d].col));
+            newValues.push_back(delta[d].value);
+          }
+          ++d;
+        } else {
+          newColIdx.push_back(ci[k]);
+          newValues.push_back(vv[k]);
+          ++k;
+        }
+      }
+      newRowPtr[r + 1] = static_cast<Index>(newColIdx.size());
+    }
+
+    row_ptr = std::move(newRowPtr);
+    col_idx = std::move(newColIdx);
+    values = std::move(newValues);
+    if (map != nullptr) {
+      ::munmap(map, map_size);
+      map = nullptr;
+      map_size = 0;
+      map_nnz = 0;
+      map_row_ptr = nullptr;
+      map_col_idx = nullptr;
+      map_values = nullptr;
+    }
+    delta.clear();
+    delta_adjust = 0;
+  }
+
+  // Lazily-built CSC companion (equivalently, the CSR arrays of the
+  // transpose). Built on first transposed access, reused until the next
+  // mutation invalidates it.
+  bool csc_valid = false;
+  std::vector<Index> csc_col_ptr;  // cols + 1 entries
+  std::vector<Index> csc_row_idx;
+  std::vector<T> csc_values;
+
+  void invalidateCsc() noexcept {
+    csc_valid = false;
+    csc_col_ptr.clear();
+    csc_row_idx.clear();
+    csc_values.clear();
+  }
+
+  void buildCsc() {
+    if (csc_valid) {
+      return;
+    }
+    compactLog();
+    const Index* rp = rowPtr();
+    const Index* ci = colIdx();
+    const T* vv = vals();
+    const std::size_t n = count();
+
+    csc_col_ptr.assign(cols + 1, 0);
+    csc_row_idx.resize(n);
+    csc_values.resize(n);
+    for (std::size_t k = 0; k < n; ++k) {
+      ++csc_col_ptr[ci[k] + 1];
+    }
+    for (std::size_t c = 0; c < cols; ++c) {
+      csc_col_ptr[c + 1] += csc_col_ptr[c];
+    }
+    std::vector<Index> offset(csc_col_ptr.begin(), csc_col_ptr.end() - 1);
+    for (std::size_t r = 0; r < rows; ++r) {
+      for (std::size_t k = rp[r]; k < rp[r + 1]; ++k) {
+        const std::size_t dest = offset[ci[k]]++;
+        csc_row_idx[dest] = static_cast<Index>(r);
+        csc_values[dest] = vv[k];
+      }
+    }
+    csc_valid = true;
+  }
+
+  // Optional BSR companion built by toBlocked(): dense block_size^2
+  // value tiles in block-row-major order. block_size == 0 means the
+  // matrix is plain CSR; mutations invalidate the companion.
+  std::size_t block_size = 0;
+  std::vector<Index> blk_row_ptr;  // block rows + 1 entries
+  std::vector<Index> blk_col_idx;  // block-column indices
+  std::vector<T> blk_values;       // block_size^2 elements per block
+
+  void invalidateBlocked() noexcept {
+    block_size = 0;
+    blk_row_ptr.clear();
+    blk_col_idx.clear();
+    blk_values.clear();
+  }
+
+  // Cached SpMV kernel choice. Depends only on the sparsity structure;
+  // mutations invalidate it and the next spmv() re-measures.
+  SpmvShape spmv_shape = SpmvShape::kGeneric;
+  bool spmv_shape_valid = false;
+
+  void invalidateShape() noexcept { spmv_shape_valid = false; }
+
+  // Column-strip companion built by toColumnStrips(): the CSR entries
+  // re-bucketed into vertical strips of strip_cols columns, each strip
+  // carrying its own rows + 1 slab of global row offsets so a strip
+  // scans like a narrow CSR matrix. strip_cols == 0 means plain CSR.
+  std::size_t strip_cols = 0;
+  std::vector<Index> strip_row_ptr;  // strips * (rows + 1) entries
+  std::vector<Index> strip_col_idx;
+  std::vector<T> strip_values;
+
+  void invalidateStrips() noexcept {
+    strip_cols = 0;
+    strip_row_ptr.clear();
+    strip_col_idx.clear();
+    strip_values.clear();
+  }
+
+  // RCM-permuted companion backing permutedView(): perm[i] is the
+  // original index at permuted position i and the prm_* arrays hold
+  // P A P^T in CSR form. Built lazily on first use, reused until a
+  // mutation invalidates it.
+  bool perm_valid = false;
+  std::vector<Index> perm;
+  std::vector<Index> prm_row_ptr;
+  std::vector<Index> prm_col_idx;
+  std::vector<T> prm_values;
+
+  void invalidatePermuted() noexcept {
+    perm_valid = false;
+    perm.clear();
+    prm_row_ptr.clear();
+    prm_col_idx.clear();
+    prm_values.clear();
+  }
+
+  // Reverse Cuthill-McKee over the symmetrized pattern: BFS from a
+  // minimum-degree seed per component, neighbors visited in increasing
+  // degree order, final order reversed. The permuted CSR is then
+  // materialized so repeated products pay no per-entry indirection.
+  void buildPermuted() {
+    if (perm_valid) {
+      return;
+    }
+    buildCsc();  // compacts the log and supplies the column adjacency
+    const std::size_t n = rows;
+    const Index* rp = rowPtr();
+    const Index* ci = colIdx();
+    const T* vv = vals();
+
+    std::vector<std::size_t> degree(n);
+    for (std::size_t v = 0; v < n; ++v) {
+      degree[v] = (rp[v + 1] - rp[v]) + (csc_col_ptr[v + 1] - csc_col_ptr[v]);
+    }
+    std::vector<bool> visited(n, false);
+    std::vector<Index> order;  // doubles as the BFS queue
+    order.reserve(n);
+    std::vector<Index> neighbors;
+    std::size_t head = 0;
+    while (order.size() < n) {
+      if (head == order.size()) {
+        std::size_t seed = n;
+        for (std::size_t v = 0; v < n; ++v) {
+          if (!visited[v] && (seed == n || degree[v] < degree[seed])) {
+            seed = v;
+          }
+        }
+        visited[seed] = true;
+        order.push_back(static_cast<Index>(seed));
+      }
+      const std::size_t v = order[head++];
+      neighbors.clear();
+      for (std::size_t k = rp[v]; k < rp[v + 1]; ++k) {
+        neighbors.push_back(ci[k]);
+      }
+      for (std::size_t k = csc_col_ptr[v]; k < csc_col_ptr[v + 1]; ++k) {
+        neighbors.push_back(csc_row_idx[k]);
+      }
+      std::sort(neighbors.begin(), neighbors.end(), [&](Index a, Index b) {
+        return degree[a] != degree[b] ? degree[a] < degree[b] : a < b;
+      });
+      for (const Index u : neighbors) {
+        if (!visited[u]) {
+          visited[u] = true;
+          order.push_back(u);
+        }
+      }
+    }
+
+    perm.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      perm[i] = order[n - 1 - i];
+    }
+    std::vector<Index> inverse(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      inverse[perm[i]] = static_cast<Index>(i);
+    }
+
+    const std::size_t n_entries = count();
+    prm_row_ptr.assign(n + 1, 0);
+    prm_col_idx.resize(n_entries);
+    prm_values.resize(n_entries);
+    std::vector<std::pair<Index, T>> rowBuf;
+    std::size_t pos = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::size_t o = perm[i];
+      rowBuf.clear();
+      for (std::size_t k = rp[o]; k < rp[o + 1]; ++k) {
+        rowBuf.emplace_back(inverse[ci[k]], vv[k]);
+      }
+      std::sort(rowBuf.begin(), rowBuf.end(),
+                [](const auto& a, const auto& b) { return a.first < b.first; });
+      for (const auto& [c, value] : rowBuf) {
+        prm_col_idx[pos] = c;
+        prm_values[pos] = value;
+        ++pos;
+      }
+      prm_row_ptr[i + 1] = static_cast<Index>(pos);
+    }
+    perm_valid = true;
+  }
+
+  // mmap-backed mode: the CSR arrays live in a read-only mapped file and
+  // the vectors above stay empty. Reads go through the accessors below so
+  // both modes share the same code paths.
+  void* map = nullptr;
+  std::size_t map_size = 0;
+  std::size_t map_nnz = 0;
+  const Index* map_row_ptr = nullptr;
+  const Index* map_col_idx = nullptr;
+  const T* map_values = nullptr;
+
+  ~Impl() {
+    if (map != nullptr) {
+      ::munmap(map, map_size);
+    }
+  }
+
+  bool mapped() const noexcept { return map != nullptr; }
+  const Index* rowPtr() const noexcept {
+    return mapped() ? map_row_ptr : row_ptr.data();
+  }
+  const Index* colIdx() const noexcept {
+    return mapped() ? map_col_idx : col_idx.data();
+  }
+  const T* vals() const noexcept {
+    return mapped() ? map_values : values.data();
+  }
+  std::size_t count() const noexcept {
+    return mapped() ? map_nnz : values.size();
+  }
+
+  // Copies the mapped arrays into owned vectors and releases the mapping;
+  // called before any mutation of a mapped matrix.
+  void materialize() {
+    if (!mapped()) {
+      return;
+    }
+    row_ptr.assign(map_row_ptr, map_row_ptr + rows + 1);
+    col_idx.assign(map_col_idx, map_col_idx + map_nnz);
+    values.assign(map_values, map_values + map_nnz);
+    ::munmap(map, map_size);
+    map = nullptr;
+    map_size = 0;
+    map_nnz = 0;
+    map_row_ptr = nullptr;
+    map_col_idx = nullptr;
+    map_values = nullptr;
+  }
+
+  // Deep copy of the logical content; a mapped source is materialized
+  // into owned vectors so the clone never shares the mapping's lifetime.
+  Impl* clone() const {
+    Impl* copy = new Impl;
+    copy->rows = rows;
+    copy->cols = cols;
+    copy->row_ptr.assign(rowPtr(), rowPtr() + rows + 1);
+    copy->col_idx.assign(colIdx(), colIdx() + count());
+    copy->values.assign(vals(), vals() + count());
+    copy->delta = delta;
+    copy->delta_adjust = delta_adjust;
+    return copy;
+  }
+
+  static void release(Impl* impl) noexcept {
+    if (impl != nullptr &&
+        impl->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete impl;
+    }
+  }
+};
+
+namespace {
+
+template <class T, class Index>
+using SpmvFn = void (*)(std::size_t rows, const Index* row_ptr,
+                        const Index* col_idx, const T* values, const T* x,
+                        T* y);
+
+template <class T, class Index>
+void spmvScalar(std::size_t rows, const Index* row_ptr, const Index* col_idx,
+                const T* values, const T* x, T* y) {
+  for (std::size_t i = 0; i < rows; ++i) {
+    T sum{};
+    for (std::size_t k = row_ptr[i]; k < row_ptr[i + 1]; ++k) {
+      sum += values[k] * x[col_idx[k]];
+    }
+    y[i] = sum;
+  }
+}
+
+#ifdef SPARSE_MATRIX_X86
+
+// The SIMD paths are written against concrete type pairs — 64-bit index
+// gathers for double and 32-bit index gathers for float — and selected
+// per instantiation in pickSpmvKernel().
+
+__attribute__((target("avx2,fma"))) void spmvAvx2F64(
+    std::size_t rows, const std::size_t* row_ptr, const std::size_t* col_idx,
+    const double* values, const double* x, double* y) {
+  for (std::size_t i = 0; i < rows; ++i) {
+    std::size_t k = row_ptr[i];
+    const std::size_t end = row_ptr[i + 1];
+    __m256d acc = _mm256_setzero_pd();
+    for (; k + 4 <= end; k += 4) {
+      const __m256i idx = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(col_idx + k));
+      const __m256d xs = _mm256_i64gather_pd(x, idx, 8);
+      const __m256d vs = _mm256_loadu_pd(values + k);
+      acc = _mm256_fmadd_pd(vs, xs, acc);
+    }
+    const __m128d lo = _mm256_castpd256_pd128(acc);
+    const __m128d hi = _mm256_extractf128_pd(acc, 1);
+    const __m128d pair = _mm_add_pd(lo, hi);
+    double sum = _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+    for (; k < end; ++k) {
+      sum += values[k] * x[col_idx[k]];
+    }
+    y[i] = sum;
+  }
+}
+
+__attribute__((target("avx512f"))) void spmvAvx512F64(
+    std::size_t rows, const std::size_t* row_ptr, const std::size_t* col_idx,
+    const double* values, const double* x, double* y) {
+  for (std::size_t i = 0; i < rows; ++i) {
+    std::size_t k = row_ptr[i];
+    const std::size_t end = row_ptr[i + 1];
+    __m512d acc = _mm512_setzero_pd();
+    for (; k + 8 <= end; k += 8) {
+      const __m512i idx = _mm512_loadu_si512(col_idx + k);
+      // Masked gather with a zeroed source avoids the undefined-value
+      // intrinsic that trips -Wmaybe-uninitialized in the GCC headers.
+      const __m512d xs = _mm512_mask_i64gather_pd(
+          _mm512_setzero_pd(), static_cast<__mmask8>(0xff), idx, x, 8);
+      const __m512d vs = _mm512_loadu_pd(values + k);
+      acc = _mm512_fmadd_pd(vs, xs, acc);
+    }
+    alignas(64) double lanes[8];
+    _mm512_store_pd(lanes, acc);
+    double sum = ((lanes[0] + lanes[4]) + (lanes[1] + lanes[5])) +
+                 ((lanes[2] + lanes[6]) + (lanes[3] + lanes[7]));
+    for (; k < end; ++k) {
+      sum += values[k] * x[col_idx[k]];
+    }
+    y[i] = sum;
+  }
+}
+
+__attribute__((target("avx2,fma"))) void spmvAvx2F32(
+    std::size_t rows, const std::uint32_t* row_ptr,
+    const std::uint32_t* col_idx, const float* values, const float* x,
+    float* y) {
+  for (std::size_t i = 0; i < rows; ++i) {
+    std::size_t k = row_ptr[i];
+    const std::size_t end = row_ptr[i + 1];
+    __m256 acc = _mm256_setzero_ps();
+    for (; k + 8 <= end; k += 8) {
+      const __m256i idx = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(col_idx + k));
+      const __m256 xs = _mm256_i32gather_ps(x, idx, 4);
+      const __m256 vs = _mm256_loadu_ps(values + k);
+      acc = _mm256_fmadd_ps(vs, xs, acc);
+    }
+    const __m128 lo = _mm256_castps256_ps128(acc);
+    const __m128 hi = _mm256_extractf128_ps(acc, 1);
+    __m128 quad = _mm_add_ps(lo, hi);
+    quad = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+    quad = _mm_add_ss(quad, _mm_shuffle_ps(quad, quad, 1));
+    float sum = _mm_cvtss_f32(quad);
+    for (; k < end; ++k) {
+      sum += values[k] * x[col_idx[k]];
+    }
+    y[i] = sum;
+  }
+}
+
+#endif  // SPARSE_MATRIX_X86
+
+template <class T, class Index>
+SpmvFn<T, Index> pickSpmvKernel() {
+#ifdef SPARSE_MATRIX_X86
+  if constexpr (std::is_same_v<T, double> &&
+                std::is_same_v<Index, std::size_t>) {
+    if (__builtin_cpu_supports("avx512f")) {
+      return spmvAvx512F64;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+      return spmvAvx2F64;
+    }
+  } else if constexpr (std::is_same_v<T, float> &&
+                       std::is_same_v<Index, std::uint32_t>) {
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+      return spmvAvx2F32;
+    }
+  }
+#endif
+  return spmvScalar<T, Index>;
+}
+
+template <class T, class Index>
+SpmvFn<T, Index> spmvKernel() {
+  static const SpmvFn<T, Index> kernel = pickSpmvKernel<T, Index>();
+  return kernel;
+}
+
+// On-disk layout: one 64-byte header followed by the raw row_ptr,
+// col_idx and values arrays, each section padded to a 64-byte boundary
+// so the mapped pointers satisfy cache-line and SIMD alignment.
+constexpr char kFileMagic[8] = {'S', 'P', 'M', 'X', 'C', 'S', 'R', '\0'};
+constexpr std::uint32_t kFileVersion = 1;
+
+// flags encode the stored types; a zero value keeps files written by the
+// double/64-bit build before the flags existed readable.
+constexpr std::uint32_t kFlagFloat32 = 1u << 0;
+constexpr std::uint32_t kFlagIndex32 = 1u << 1;
+
+template <class T, class Index>
+constexpr std::uint32_t fileFlags() {
+  return (std::is_same_v<T, float> ? kFlagFloat32 : 0u) |
+         (sizeof(Index) == 4 ? kFlagIndex32 : 0u);
+}
+
+struct FileHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t flags;
+  std::uint64_t rows;
+  std::uint64_t cols;
+  std::uint64_t nnz;
+  char reserved[24];
+};
+static_assert(sizeof(FileHeader) == 64, "header must stay 64 bytes");
+
+constexpr std::size_t alignUp64(std::size_t n) {
+  return (n + 63) & ~static_cast<std::size_t>(63);
 }
 
-std::size_t SparseMatrix::rows() const noexcept {
-  return 0;
+// Positioned read that retries short reads; returns false on error or
+// end of file before `bytes`.
+bool preadFull(int fd, void* dst, std::size_t bytes, std::size_t offset) {
+  char* out = static_cast<char*>(dst);
+  while (bytes != 0) {
+    const ssize_t got = ::pread(fd, out, bytes, static_cast<off_t>(offset));
+    if (got <= 0) {
+      return false;
+    }
+    out += got;
+    offset += static_cast<std::size_t>(got);
+    bytes -= static_cast<std::size_t>(got);
+  }
+  return true;
 }
 
-std::size_t SparseMatrix::cols() const noexcept {
-  return 0;
+template <class Triplet>
+bool tripletLess(const Triplet& a, const Triplet& b) {
+  return a.row != b.row ? a.row < b.row : a.col < b.col;
 }
 
-std::size_t SparseMatrix::nnz() const noexcept {
-  return 0;
+// Sorts triplets by (row, col) with a stable chunked merge sort: chunks
+// are sorted on worker threads, then merged pairwise. Stability keeps
+// duplicate entries in submission order for the overwrite policy.
+template <class Triplet>
+void sortTriplets(std::vector<Triplet>& triplets) {
+  const std::size_t n = triplets.size();
+  std::size_t workers = std::thread::hardware_concurrency();
+  if (workers == 0) {
+    workers = 1;
+  }
+  // Below this size thread spawn overhead dominates the sort itself.
+  constexpr std::size_t kMinParallelSize = 1u << 16;
+  if (workers == 1 || n < kMinParallelSize) {
+    std::stable_sort(triplets.begin(), triplets.end(), tripletLess<Triplet>);
+    return;
+  }
+
+  const std::size_t chunk = (n + workers - 1) / workers;
+  std::vector<std::size_t> bounds;
+  for (std::size_t begin = 0; begin < n; begin += chunk) {
+    bounds.push_back(begin);
+  }
+  bounds.push_back(n);
+
+  std::vector<std::thread> threads;
+  threads.reserve(bounds.size() - 1);
+  for (std::size_t c = 0; c + 1 < bounds.size(); ++c) {
+    threads.emplace_back([&triplets, &bounds, c]() {
+      std::stable_sort(triplets.begin() + bounds[c],
+                       triplets.begin() + bounds[c + 1], tripletLess<Triplet>);
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  // Pairwise merge rounds; each round halves the number of sorted runs.
+  while (bounds.size() > 2) {
+    std::vector<std::size_t> next;
+    std::vector<std::thread> mergers;
+    for (std::size_t c = 0; c + 2 < bounds.size(); c += 2) {
+      mergers.emplace_back([&triplets, &bounds, c]() {
+        std::inplace_merge(triplets.begin() + bounds[c],
+                           triplets.begin() + bounds[c + 1],
+                           triplets.begin() + bounds[c + 2],
+                           tripletLess<Triplet>);
+      });
+      next.push_back(bounds[c]);
+    }
+    if (bounds.size() % 2 == 0) {
+      next.push_back(bounds[bounds.size() - 2]);
+    }
+    next.push_back(n);
+    for (auto& t : mergers) {
+      t.join();
+    }
+    bounds = std::move(next);
+  }
+}
+
+}  // namespace
+
+template <class T, class Index>
+BasicSparseMatrix<T, Index>::Arena::Arena(std::size_t chunkBytes)
+    : chunk_bytes_(chunkBytes == 0 ? std::size_t{1} << 20 : chunkBytes) {}
+
+template <class T, class Index>
+BasicSparseMatrix<T, Index>::Arena::~Arena() {
+  for (auto& [base, capacity] : chunks_) {
+    ::operator delete(base, std::align_val_t{64});
+  }
+}
+
+template <class T, class Index>
+void* BasicSparseMatrix<T, Index>::Arena::allocate(std::size_t bytes,
+                                                   std::size_t alignment) {
+  if (bytes == 0) {
+    bytes = 1;
+  }
+  while (true) {
+    if (current_ < chunks_.size()) {
+      auto& [base, capacity] = chunks_[current_];
+      const std::size_t aligned =
+          (offset_ + alignment - 1) & ~(alignment - 1);
+      if (aligned + bytes <= capacity) {
+        offset_ = aligned + bytes;
+        return base + aligned;
+      }
+      // Current chunk exhausted; fall through to the next (or a new) one.
+      ++current_;
+      offset_ = 0;
+      continue;
+    }
+    const std::size_t capacity = std::max(chunk_bytes_, bytes + alignment);
+    char* base = static_cast<char*>(
+        ::operator new(capacity, std::align_val_t{64}));
+    chunks_.emplace_back(base, capacity);
+  }
+}
+
+template <class T, class Index>
+void BasicSparseMatrix<T, Index>::Arena::reset() noexcept {
+  current_ = 0;
+  offset_ = 0;
+}
+
+template <class T, class Index>
+BasicSparseMatrix<T, Index>::BasicSparseMatrix(std::size_t rows,
+                                               std::size_t cols)
+    : impl_(new Impl) {
+  impl_->rows = rows;
+  impl_->cols = cols;
+  impl_->row_ptr.assign(rows + 1, 0);
+}
+
+template <class T, class Index>
+BasicSparseMatrix<T, Index>::~BasicSparseMatrix() {
+  Impl::release(impl_);
+}
+
+template <class T, class Index>
+BasicSparseMatrix<T, Index>::BasicSparseMatrix(
+    BasicSparseMatrix&& other) noexcept
+    : impl_(std::exchange(other.impl_, nullptr)) {}
+
+template <class T, class Index>
+BasicSparseMatrix<T, Index>& BasicSparseMatrix<T, Index>::operator=(
+    BasicSparseMatrix&& other) noexcept {
+  if (this != &other) {
+    Impl::release(impl_);
+    impl_ = std::exchange(other.impl_, nullptr);
+  }
+  return *this;
+}
+
+template <class T, class Index>
+BasicSparseMatrix<T, Index>::BasicSparseMatrix(
+    const BasicSparseMatrix& other) noexcept
+    : impl_(other.impl_) {
+  impl_->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <class T, class Index>
+BasicSparseMatrix<T, Index>& BasicSparseMatrix<T, Index>::operator=(
+    const BasicSparseMatrix& other) noexcept {
+  if (impl_ != other.impl_) {
+    other.impl_->refs.fetch_add(1, std::memory_order_relaxed);
+    Impl::release(impl_);
+    impl_ = other.impl_;
+  }
+  return *this;
+}
+
+template <class T, class Index>
+void BasicSparseMatrix<T, Index>::detach() {
+  if (impl_->refs.load(std::memory_order_acquire) > 1) {
+    Impl* copy = impl_->clone();
+    Impl::release(impl_);
+    impl_ = copy;
+  }
+}
+
+template <class T, class Index>
+BasicSparseMatrix<T, Index> BasicSparseMatrix<T, Index>::fromTriplets(
+    std::size_t rows, std::size_t cols, std::vector<Triplet>&& triplets,
+    DuplicatePolicy policy) {
+  for (const Triplet& t : triplets) {
+    if (t.row >= rows || t.col >= cols) {
+      throw std::out_of_range("SparseMatrix::fromTriplets: index out of range");
+    }
+  }
+  sortTriplets(triplets);
+
+  BasicSparseMatrix result(rows, cols);
+  Impl& out = *result.impl_;
+  out.col_idx.reserve(triplets.size());
+  out.values.reserve(triplets.size());
+
+  std::size_t k = 0;
+  while (k < triplets.size()) {
+    const std::size_t row = triplets[k].row;
+    const std::size_t col = triplets[k].col;
+    T value = triplets[k].value;
+    for (++k; k < triplets.size() && triplets[k].row == row &&
+              triplets[k].col == col;
+         ++k) {
+      if (policy == DuplicatePolicy::kSum) {
+        value += triplets[k].value;
+      } else {
+        value = triplets[k].value;
+      }
+    }
+    if (value != T{}) {
+      out.col_idx.push_back(static_cast<Index>(col));
+      out.values.push_back(value);
+      ++out.row_ptr[row + 1];
+    }
+  }
+  for (std::size_t r = 0; r < rows; ++r) {
+    out.row_ptr[r + 1] += out.row_ptr[r];
+  }
+  triplets.clear();
+  return result;
 }
 
-double SparseMatrix::get(std::size_t, std::size_t) const {
-  throw std::logic_error("not implemented");
+template <class T, class Index>
+std::size_t BasicSparseMatrix<T, Index>::rows() const noexcept {
+  return impl_->rows;
 }
 
-void SparseMatrix::set(std::size_t, std::size_t, double) {
-  throw std::logic_error("not implemented");
+template <class T, class Index>
+std::size_t BasicSparseMatrix<T, Index>::cols() const noexcept {
+  return impl_->cols;
 }
 
-SparseMatrix SparseMatrix::transpose() const {
-  throw std::logic_error("not implemented");
+template <class T, class Index>
+std::size_t BasicSparseMatrix<T, Index>::nnz() const noexcept {
+  return static_cast<std::size_t>(
+      static_cast<std::ptrdiff_t>(impl_->count()) + impl_->delta_adjust);
 }
 
-SparseMatrix SparseMatrix::multiply(const SparseMatrix&) const {
-  throw std::logic_error("not implemented");
+template <class T, class Index>
+T BasicSparseMatrix<T, Index>::get(std::size_t row, std::size_t col) const {
+  if (row >= impl_->rows || col >= impl_->cols) {
+    throw std::out_of_range("SparseMatrix::get: index out of range");
+  }
+  if (!impl_->delta.empty()) {
+    const auto it = std::lower_bound(
+        impl_->delta.begin(), impl_->delta.end(), std::make_pair(row, col),
+        [](const typename Impl::Delta& d,
+           const std::pair<std::size_t, std::size_t>& p) {
+          return d.row != p.first ? d.row < p.first : d.col < p.second;
+        });
+    if (it != impl_->delta.end() && it->row == row && it->col == col) {
+      return it->value;
+    }
+  }
+  const Index* ci = impl_->colIdx();
+  const Index* begin = ci + impl_->rowPtr()[row];
+  const Index* end = ci + impl_->rowPtr()[row + 1];
+  const Index* it = std::lower_bound(begin, end, static_cast<Index>(col));
+  if (it == end || *it != col) {
+    return T{};
+  }
+  return impl_->vals()[static_cast<std::size_t>(it - ci)];
 }
+
+template <class T, class Index>
+void BasicSparseMatrix<T, Index>::set(std::size_t row, std::size_t col,
+                                      T value) {
+  if (row >= impl_->rows || col >= impl_->cols) {
+    throw std::out_of_range("SparseMatrix::set: index out of range");
+  }
+  detach();
+  impl_->invalidateBlocked();
+  impl_->invalidateCsc();
+  impl_->invalidateShape();
+  impl_->invalidateStrips();
+  impl_->invalidatePermuted();
+
+  const auto it = std::lower_bound(
+      impl_->delta.begin(), impl_->delta.end(), std::make_pair(row, col),
+      [](const typename Impl::Delta& d,
+         const std::pair<std::size_t, std::size_t>& p) {
+        return d.row != p.first ? d.row < p.first : d.col < p.second;
+      });
+  if (it != impl_->delta.end() && it->row == row && it->col == col) {
+    impl_->delta_adjust -= Impl::deltaContribution(*it);
+    it->value = value;
+    impl_->delta_adjust += Impl::deltaContribution(*it);
+    return;
+  }
+
+  const Index* ci = impl_->colIdx();
+  const Index* begin = ci + impl_->rowPtr()[row];
+  const Index* end = ci + impl_->rowPtr()[row + 1];
+  const Index* csr = std::lower_bound(begin, end, static_cast<Index>(col));
+  const bool inCsr = csr != end && *csr == col;
+  if (!inCsr && value == T{}) {
+    return;  // deleting an absent entry is a no-op
+  }
+  const typename Impl::Delta entry{row, col, value, inCsr};
+  impl_->delta_adjust += Impl::deltaContribution(entry);
+  impl_->delta.insert(it, entry);
+  if (impl_->delta.size() >= Impl::kCompactThreshold) {
+    impl_->compactLog();
+  }
+}
+
+template <class T, class Index>
+void BasicSparseMatrix<T, Index>::compact() {
+  impl_->compactLog();
+}
+
+template <class T, class Index>
+const Index* BasicSparseMatrix<T, Index>::rawRowPtr() const {
+  impl_->compactLog();
+  return impl_->rowPtr();
+}
+
+template <class T, class Index>
+const Index* BasicSparseMatrix<T, Index>::rawColIdx() const {
+  impl_->compactLog();
+  return impl_->colIdx();
+}
+
+template <class T, class Index>
+const T* BasicSparseMatrix<T, Index>::rawValues() const {
+  impl_->compactLog();
+  return impl_->vals();
+}
+
+template <class T, class Index>
+BasicSparseMatrix<T, Index> BasicSparseMatrix<T, Index>::transposeWithScratch(
+    std::size_t* offset) const {
+  impl_->compactLog();
+  BasicSparseMatrix result(impl_->cols, impl_->rows);
+  Impl& out = *result.impl_;
+  const std::size_t count = nnz();
+  out.col_idx.resize(count);
+  out.values.resize(count);
+
+  const Index* rp = impl_->rowPtr();
+  const Index* ci = impl_->colIdx();
+  const T* vv = impl_->vals();
+
+  // Histogram column occupancy into the new row_ptr, then prefix-sum.
+  for (std::size_t k = 0; k < count; ++k) {
+    ++out.row_ptr[ci[k] + 1];
+  }
+  for (std::size_t r = 0; r < out.rows; ++r) {
+    out.row_ptr[r + 1] += out.row_ptr[r];
+  }
+
+  std::copy(out.row_ptr.begin(), out.row_ptr.end() - 1, offset);
+  for (std::size_t i = 0; i < impl_->rows; ++i) {
+    for (std::size_t k = rp[i]; k < rp[i + 1]; ++k) {
+      const std::size_t dest = offset[ci[k]]++;
+      out.col_idx[dest] = static_cast<Index>(i);
+      out.values[dest] = vv[k];
+    }
+  }
+  return result;
+}
+
+template <class T, class Index>
+BasicSparseMatrix<T, Index> BasicSparseMatrix<T, Index>::transpose() const {
+  std::vector<std::size_t> offset(impl_->cols);
+  return transposeWithScratch(offset.data());
+}
+
+template <class T, class Index>
+BasicSparseMatrix<T, Index> BasicSparseMatrix<T, Index>::transpose(
+    Arena& arena) const {
+  return transposeWithScratch(
+      arena.template allocate<std::size_t>(impl_->cols));
+}
+
+template <class T, class Index>
+BasicSparseMatrix<T, Index> BasicSparseMatrix<T, Index>::transposeParallel(
+    std::size_t numThreads) const {
+  impl_->compactLog();
+  if (numThreads == 0) {
+    numThreads = std::thread::hardware_concurrency();
+    if (numThreads == 0) {
+      numThreads = 1;
+    }
+  }
+  numThreads = std::min(numThreads, std::max<std::size_t>(impl_->rows, 1));
+  if (numThreads == 1) {
+    return transpose();
+  }
+
+  const Index* rp = impl_->rowPtr();
+  const Index* ci = impl_->colIdx();
+  const T* vv = impl_->vals();
+  const std::size_t rows = impl_->rows;
+  const std::size_t cols = impl_->cols;
+  const std::size_t chunk = (rows + numThreads - 1) / numThreads;
+
+  BasicSparseMatrix result(cols, rows);
+  Impl& out = *result.impl_;
+  out.col_idx.resize(impl_->count());
+  out.values.resize(impl_->count());
+
+  // Pass 1: each worker histograms the columns of its row range.
+  std::vector<std::vector<std::size_t>> counts(
+      numThreads, std::vector<std::size_t>(cols, 0));
+  {
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads);
+    for (std::size_t t = 0; t < numThreads; ++t) {
+      threads.emplace_back([&, t]() {
+        const std::size_t rowBegin = std::min(t * chunk, rows);
+        const std::size_t rowEnd = std::min(rowBegin + chunk, rows);
+        std::vector<std::size_t>& local = counts[t];
+        for (std::size_t k = rp[rowBegin]; k < rp[rowEnd]; ++k) {
+          ++local[ci[k]];
+        }
+      });
+    }
+    for (auto& th : threads) {
+      th.join();
+    }
+  }
+
+  // Serial combine: per-column totals become the output row_ptr, and the
+  // running per-worker sums become each worker's private scatter cursor,
+  // so pass 2 needs no atomics. Ascending row ranges keep every output
+  // row sorted.
+  for (std::size_t c = 0; c < cols; ++c) {
+    std::size_t total = 0;
+    for (std::size_t t = 0; t < numThreads; ++t) {
+      const std::size_t n = counts[t][c];
+      counts[t][c] = total;
+      total += n;
+    }
+    out.row_ptr[c + 1] = static_cast<Index>(total);
+  }
+  for (std::size_t c = 0; c < cols; ++c) {
+    out.row_ptr[c + 1] += out.row_ptr[c];
+  }
+
+  // Pass 2: scatter into disjoint ranges.
+  {
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads);
+    for (std::size_t t = 0; t < numThreads; ++t) {
+      threads.emplace_back([&, t]() {
+        const std::size_t rowBegin = std::min(t * chunk, rows);
+        const std::size_t rowEnd = std::min(rowBegin + chunk, rows);
+        std::vector<std::size_t>& cursor = counts[t];
+        for (std::size_t i = rowBegin; i < rowEnd; ++i) {
+          for (std::size_t k = rp[i]; k < rp[i + 1]; ++k) {
+            const std::size_t c = ci[k];
+            const std::size_t dest = out.row_ptr[c] + cursor[c]++;
+            out.col_idx[dest] = static_cast<Index>(i);
+            out.values[dest] = vv[k];
+          }
+        }
+      });
+    }
+    for (auto& th : threads) {
+      th.join();
+    }
+  }
+  return result;
+}
+
+// Gustavson's algorithm: one dense accumulator row reused across rows.
+// All three scratch arrays must hold rhs.cols() slots; marker must be
+// zero-initialized. acc may be uninitialized — the marker tells first
+// touches apart from accumulations, which also bounds touched at one
+// entry per column.
+template <class T, class Index>
+BasicSparseMatrix<T, Index> BasicSparseMatrix<T, Index>::multiplyWithScratch(
+    const BasicSparseMatrix& rhs, T* acc, std::size_t* touched,
+    std::size_t* marker) const {
+  impl_->compactLog();
+  rhs.impl_->compactLog();
+  BasicSparseMatrix result(impl_->rows, rhs.impl_->cols);
+  Impl& out = *result.impl_;
+
+  const Index* arp = impl_->rowPtr();
+  const Index* aci = impl_->colIdx();
+  const T* avv = impl_->vals();
+  const Index* brp = rhs.impl_->rowPtr();
+  const Index* bci = rhs.impl_->colIdx();
+  const T* bvv = rhs.impl_->vals();
+
+  for (std::size_t i = 0; i < impl_->rows; ++i) {
+    std::size_t touchedCount = 0;
+    for (std::size_t ka = arp[i]; ka < arp[i + 1]; ++ka) {
+      const std::size_t j = aci[ka];
+      const T a = avv[ka];
+      for (std::size_t kb = brp[j]; kb < brp[j + 1]; ++kb) {
+        const std::size_t c = bci[kb];
+        const T contribution = a * bvv[kb];
+        if (marker[c] != i + 1) {
+          marker[c] = i + 1;
+          acc[c] = contribution;
+          touched[touchedCount++] = c;
+        } else {
+          acc[c] += contribution;
+        }
+      }
+    }
+    std::sort(touched, touched + touchedCount);
+    for (std::size_t t = 0; t < touchedCount; ++t) {
+      const std::size_t c = touched[t];
+      if (acc[c] != T{}) {
+        out.col_idx.push_back(static_cast<Index>(c));
+        out.values.push_back(acc[c]);
+      }
+    }
+    out.row_ptr[i + 1] = static_cast<Index>(out.col_idx.size());
+  }
+  return result;
+}
+
+template <class T, class Index>
+BasicSparseMatrix<T, Index> BasicSparseMatrix<T, Index>::multiply(
+    const BasicSparseMatrix& rhs) const {
+  if (impl_->cols != rhs.impl_->rows) {
+    throw std::invalid_argument("SparseMatrix::multiply: shape mismatch");
+  }
+  std::vector<T> acc(rhs.impl_->cols);
+  std::vector<std::size_t> touched(rhs.impl_->cols);
+  std::vector<std::size_t> marker(rhs.impl_->cols, 0);
+  return multiplyWithScratch(rhs, acc.data(), touched.data(), marker.data());
+}
+
+template <class T, class Index>
+BasicSparseMatrix<T, Index> BasicSparseMatrix<T, Index>::multiply(
+    const BasicSparseMatrix& rhs, Arena& arena) const {
+  if (impl_->cols != rhs.impl_->rows) {
+    throw std::invalid_argument("SparseMatrix::multiply: shape mismatch");
+  }
+  T* acc = arena.template allocate<T>(rhs.impl_->cols);
+  std::size_t* touched = arena.template allocate<std::size_t>(rhs.impl_->cols);
+  std::size_t* marker = arena.template allocate<std::size_t>(rhs.impl_->cols);
+  std::fill(marker, marker + rhs.impl_->cols, 0);
+  return multiplyWithScratch(rhs, acc, touched, marker);
+}
+
+template <class T, class Index>
+auto BasicSparseMatrix<T, Index>::planMultiply(const BasicSparseMatrix& rhs)
+    const -> MultiplyPlan {
+  if (impl_->cols != rhs.impl_->rows) {
+    throw std::invalid_argument("SparseMatrix::planMultiply: shape mismatch");
+  }
+  impl_->compactLog();
+  rhs.impl_->compactLog();
+  MultiplyPlan plan;
+  plan.rows_ = impl_->rows;
+  plan.inner_ = impl_->cols;
+  plan.cols_ = rhs.impl_->cols;
+  plan.row_ptr_.assign(impl_->rows + 1, 0);
+
+  const Index* arp = impl_->rowPtr();
+  const Index* aci = impl_->colIdx();
+  const Index* brp = rhs.impl_->rowPtr();
+  const Index* bci = rhs.impl_->colIdx();
+
+  // Symbolic Gustavson pass: pattern only, no value arithmetic.
+  std::vector<bool> seen(rhs.impl_->cols, false);
+  std::vector<std::size_t> touched;
+  for (std::size_t i = 0; i < impl_->rows; ++i) {
+    touched.clear();
+    for (std::size_t ka = arp[i]; ka < arp[i + 1]; ++ka) {
+      const std::size_t j = aci[ka];
+      for (std::size_t kb = brp[j]; kb < brp[j + 1]; ++kb) {
+        const std::size_t c = bci[kb];
+        if (!seen[c]) {
+          seen[c] = true;
+          touched.push_back(c);
+        }
+      }
+    }
+    std::sort(touched.begin(), touched.end());
+    for (const std::size_t c : touched) {
+      plan.col_idx_.push_back(static_cast<Index>(c));
+      seen[c] = false;
+    }
+    plan.row_ptr_[i + 1] = static_cast<Index>(plan.col_idx_.size());
+  }
+  return plan;
+}
+
+template <class T, class Index>
+void BasicSparseMatrix<T, Index>::MultiplyPlan::execute(
+    const BasicSparseMatrix& a, const BasicSparseMatrix& b,
+    BasicSparseMatrix& c) const {
+  if (a.impl_->rows != rows_ || a.impl_->cols != inner_ ||
+      b.impl_->rows != inner_ || b.impl_->cols != cols_) {
+    throw std::invalid_argument(
+        "MultiplyPlan::execute: operand shapes do not match the plan");
+  }
+  a.impl_->compactLog();
+  b.impl_->compactLog();
+  c.detach();
+  c.impl_->materialize();
+  c.impl_->delta.clear();
+  c.impl_->delta_adjust = 0;
+  c.impl_->invalidateBlocked();
+  c.impl_->invalidateCsc();
+  c.impl_->invalidateShape();
+  c.impl_->invalidateStrips();
+  c.impl_->invalidatePermuted();
+  Impl& out = *c.impl_;
+  out.rows = rows_;
+  out.cols = cols_;
+  out.row_ptr = row_ptr_;
+  out.col_idx = col_idx_;
+  out.values.assign(col_idx_.size(), T{});
+
+  const Index* arp = a.impl_->rowPtr();
+  const Index* aci = a.impl_->colIdx();
+  const T* avv = a.impl_->vals();
+  const Index* brp = b.impl_->rowPtr();
+  const Index* bci = b.impl_->colIdx();
+  const T* bvv = b.impl_->vals();
+
+  // Numeric phase: refill values in the cached pattern.
+  std::vector<T> acc(cols_, T{});
+  for (std::size_t i = 0; i < rows_; ++i) {
+    for (std::size_t ka = arp[i]; ka < arp[i + 1]; ++ka) {
+      const std::size_t j = aci[ka];
+      const T av = avv[ka];
+      for (std::size_t kb = brp[j]; kb < brp[j + 1]; ++kb) {
+        acc[bci[kb]] += av * bvv[kb];
+      }
+    }
+    for (std::size_t k = row_ptr_[i]; k < row_ptr_[i + 1]; ++k) {
+      out.values[k] = acc[col_idx_[k]];
+      acc[col_idx_[k]] = T{};
+    }
+  }
+}
+
+template <class T, class Index>
+BasicSparseMatrix<T, Index> BasicSparseMatrix<T, Index>::multiplyParallel(
+    const BasicSparseMatrix& rhs, std::size_t numThreads) const {
+  if (impl_->cols != rhs.impl_->rows) {
+    throw std::invalid_argument(
+        "SparseMatrix::multiplyParallel: shape mismatch");
+  }
+  impl_->compactLog();
+  rhs.impl_->compactLog();
+  if (numThreads == 0) {
+    numThreads = std::thread::hardware_concurrency();
+    if (numThreads == 0) {
+      numThreads = 1;
+    }
+  }
+  numThreads = std::min(numThreads, std::max<std::size_t>(impl_->rows, 1));
+  if (numThreads == 1) {
+    return multiply(rhs);
+  }
+
+  // Per-thread output block: CSR fragments for a contiguous row range.
+  struct Block {
+    std::vector<Index> col_idx;
+    std::vector<T> values;
+    std::vector<std::size_t> row_nnz;
+  };
+  std::vector<Block> blocks(numThreads);
+  const std::size_t chunk = (impl_->rows + numThreads - 1) / numThreads;
+
+  auto worker = [this, &rhs](std::size_t rowBegin, std::size_t rowEnd,
+                             Block& block) {
+    const Index* arp = impl_->rowPtr();
+    const Index* aci = impl_->colIdx();
+    const T* avv = impl_->vals();
+    const Index* brp = rhs.impl_->rowPtr();
+    const Index* bci = rhs.impl_->colIdx();
+    const T* bvv = rhs.impl_->vals();
+    std::vector<T> acc(rhs.impl_->cols, T{});
+    std::vector<std::size_t> touched;
+    block.row_nnz.reserve(rowEnd - rowBegin);
+    for (std::size_t i = rowBegin; i < rowEnd; ++i) {
+      touched.clear();
+      for (std::size_t ka = arp[i]; ka < arp[i + 1]; ++ka) {
+        const std::size_t j = aci[ka];
+        const T av = avv[ka];
+        for (std::size_t kb = brp[j]; kb < brp[j + 1]; ++kb) {
+          const std::size_t c = bci[kb];
+          if (acc[c] == T{}) {
+            touched.push_back(c);
+          }
+          acc[c] += av * bvv[kb];
+        }
+      }
+      std::sort(touched.begin(), touched.end());
+      std::size_t emitted = 0;
+      for (const std::size_t c : touched) {
+        if (acc[c] != T{}) {
+          block.col_idx.push_back(static_cast<Index>(c));
+          block.values.push_back(acc[c]);
+          ++emitted;
+        }
+        acc[c] = T{};
+      }
+      block.row_nnz.push_back(emitted);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads);
+  for (std::size_t t = 0; t < numThreads; ++t) {
+    const std::size_t rowBegin = std::min(t * chunk, impl_->rows);
+    const std::size_t rowEnd = std::min(rowBegin + chunk, impl_->rows);
+    threads.emplace_back(worker, rowBegin, rowEnd, std::ref(blocks[t]));
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  BasicSparseMatrix result(impl_->rows, rhs.impl_->cols);
+  Impl& out = *result.impl_;
+  std::size_t total = 0;
+  for (const Block& block : blocks) {
+    total += block.col_idx.size();
+  }
+  out.col_idx.reserve(total);
+  out.values.reserve(total);
+  std::size_t row = 0;
+  for (const Block& block : blocks) {
+    for (const std::size_t count : block.row_nnz) {
+      out.row_ptr[row + 1] = out.row_ptr[row] + static_cast<Index>(count);
+      ++row;
+    }
+    out.col_idx.insert(out.col_idx.end(), block.col_idx.begin(),
+                       block.col_idx.end());
+    out.values.insert(out.values.end(), block.values.begin(),
+                      block.values.end());
+  }
+  return result;
+}
+
+template <class T, class Index>
+void BasicSparseMatrix<T, Index>::toBlocked(std::size_t blockSize) {
+  if (blockSize == 0 || blockSize > 16) {
+    throw std::invalid_argument(
+        "SparseMatrix::toBlocked: block size must be in [1, 16]");
+  }
+  Impl& m = *impl_;
+  if (m.block_size == blockSize) {
+    return;
+  }
+  m.compactLog();
+  m.invalidateBlocked();
+  m.invalidateStrips();  // the two acceleration modes are exclusive
+
+  const std::size_t bs = blockSize;
+  const std::size_t blockRows = (m.rows + bs - 1) / bs;
+  const std::size_t blockCols = (m.cols + bs - 1) / bs;
+  const Index* rp = m.rowPtr();
+  const Index* ci = m.colIdx();
+  const T* vv = m.vals();
+
+  m.blk_row_ptr.assign(blockRows + 1, 0);
+  // slot[bc] maps a block column to its position in the current block
+  // row's list; npos means unseen.
+  constexpr std::size_t kNoSlot = static_cast<std::size_t>(-1);
+  std::vector<std::size_t> slot(blockCols, kNoSlot);
+  std::vector<std::size_t> seen;
+
+  for (std::size_t bi = 0; bi < blockRows; ++bi) {
+    const std::size_t rowEnd = std::min(m.rows, (bi + 1) * bs);
+    const std::size_t listBase = m.blk_col_idx.size();
+    seen.clear();
+    for (std::size_t r = bi * bs; r < rowEnd; ++r) {
+      for (std::size_t k = rp[r]; k < rp[r + 1]; ++k) {
+        const std::size_t bc = ci[k] / bs;
+        if (slot[bc] == kNoSlot) {
+          slot[bc] = m.blk_col_idx.size() - listBase;
+          m.blk_col_idx.push_back(static_cast<Index>(bc));
+          m.blk_values.insert(m.blk_values.end(), bs * bs, T{});
+          seen.push_back(bc);
+        }
+        T* block = m.blk_values.data() + (listBase + slot[bc]) * bs * bs;
+        block[(r - bi * bs) * bs + (ci[k] - bc * bs)] = vv[k];
+      }
+    }
+    // Keep block columns sorted within the block row for locality.
+    const std::size_t listSize = m.blk_col_idx.size() - listBase;
+    std::vector<std::size_t> order(listSize);
+    for (std::size_t s = 0; s < listSize; ++s) {
+      order[s] = s;
+    }
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+      return m.blk_col_idx[listBase + a] < m.blk_col_idx[listBase + b];
+    });
+    std::vector<Index> sortedCols(listSize);
+    std::vector<T> sortedVals(listSize * bs * bs);
+    for (std::size_t s = 0; s < listSize; ++s) {
+      sortedCols[s] = m.blk_col_idx[listBase + order[s]];
+      std::copy_n(m.blk_values.begin() +
+                      static_cast<std::ptrdiff_t>((listBase + order[s]) * bs *
+                                                  bs),
+                  bs * bs,
+                  sortedVals.begin() + static_cast<std::ptrdiff_t>(s * bs * bs));
+    }
+    std::copy(sortedCols.begin(), sortedCols.end(),
+              m.blk_col_idx.begin() + static_cast<std::ptrdiff_t>(listBase));
+    std::copy(sortedVals.begin(), sortedVals.end(),
+              m.blk_values.begin() +
+                  static_cast<std::ptrdiff_t>(listBase * bs * bs));
+    for (const std::size_t bc : seen) {
+      slot[bc] = kNoSlot;
+    }
+    m.blk_row_ptr[bi + 1] = static_cast<Index>(m.blk_col_idx.size());
+  }
+  m.block_size = bs;
+}
+
+template <class T, class Index>
+std::size_t BasicSparseMatrix<T, Index>::blockSize() const noexcept {
+  return impl_->block_size;
+}
+
+template <class T, class Index>
+void BasicSparseMatrix<T, Index>::toColumnStrips(std::size_t stripCols) {
+  if (stripCols == 0) {
+    stripCols = (std::size_t{256} << 10) / sizeof(T);
+  }
+  Impl& m = *impl_;
+  if (m.strip_cols == stripCols) {
+    return;
+  }
+  m.compactLog();
+  m.invalidateStrips();
+  m.invalidateBlocked();  // the two acceleration modes are exclusive
+
+  const std::size_t strips =
+      m.cols == 0 ? 0 : (m.cols + stripCols - 1) / stripCols;
+  const std::size_t slab = m.rows + 1;
+  const Index* rp = m.rowPtr();
+  const Index* ci = m.colIdx();
+  const T* vv = m.vals();
+  const std::size_t n = m.count();
+
+  m.strip_row_ptr.assign(strips * slab, 0);
+  m.strip_col_idx.resize(n);
+  m.strip_values.resize(n);
+
+  // Pass 1: count entries per (strip, row) into each slab's +1 slots.
+  for (std::size_t r = 0; r < m.rows; ++r) {
+    for (std::size_t k = rp[r]; k < rp[r + 1]; ++k) {
+      ++m.strip_row_ptr[(ci[k] / stripCols) * slab + r + 1];
+    }
+  }
+  // Prefix over the slabs in storage order turns the counts into global
+  // offsets; slot [s * slab + r] is where (strip s, row r) begins.
+  std::size_t running = 0;
+  for (std::size_t s = 0; s < strips; ++s) {
+    m.strip_row_ptr[s * slab] = static_cast<Index>(running);
+    for (std::size_t r = 0; r < m.rows; ++r) {
+      running += m.strip_row_ptr[s * slab + r + 1];
+      m.strip_row_ptr[s * slab + r + 1] = static_cast<Index>(running);
+    }
+  }
+  // Pass 2: scatter. The row scan is column-sorted, so entries land
+  // sorted within each (strip, row) cell too.
+  std::vector<Index> cursor(m.strip_row_ptr.begin(), m.strip_row_ptr.end());
+  for (std::size_t r = 0; r < m.rows; ++r) {
+    for (std::size_t k = rp[r]; k < rp[r + 1]; ++k) {
+      const std::size_t s = ci[k] / stripCols;
+      const std::size_t dest = cursor[s * slab + r]++;
+      m.strip_col_idx[dest] = ci[k];
+      m.strip_values[dest] = vv[k];
+    }
+  }
+  m.strip_cols = stripCols;
+}
+
+template <class T, class Index>
+std::size_t BasicSparseMatrix<T, Index>::stripCols() const noexcept {
+  return impl_->strip_cols;
+}
+
+template <class T, class Index>
+auto BasicSparseMatrix<T, Index>::transposedView() const -> TransposedView {
+  return TransposedView(*this);
+}
+
+template <class T, class Index>
+std::size_t BasicSparseMatrix<T, Index>::TransposedView::rows()
+    const noexcept {
+  return base_->impl_->cols;
+}
+
+template <class T, class Index>
+std::size_t BasicSparseMatrix<T, Index>::TransposedView::cols()
+    const noexcept {
+  return base_->impl_->rows;
+}
+
+template <class T, class Index>
+void BasicSparseMatrix<T, Index>::TransposedView::spmv(std::span<const T> x,
+                                                       std::span<T> y) const {
+  Impl& m = *base_->impl_;
+  if (x.size() != m.rows || y.size() != m.cols) {
+    throw std::invalid_argument("TransposedView::spmv: shape mismatch");
+  }
+  m.buildCsc();
+  // The CSC companion is the transpose's CSR layout, so the flat SpMV
+  // kernel applies directly.
+  spmvKernel<T, Index>()(m.cols, m.csc_col_ptr.data(), m.csc_row_idx.data(),
+                         m.csc_values.data(), x.data(), y.data());
+}
+
+template <class T, class Index>
+std::vector<T> BasicSparseMatrix<T, Index>::TransposedView::multiply(
+    const std::vector<T>& x) const {
+  std::vector<T> y(base_->impl_->cols, T{});
+  spmv(x, y);
+  return y;
+}
+
+template <class T, class Index>
+auto BasicSparseMatrix<T, Index>::permutedView() const -> PermutedView {
+  if (impl_->rows != impl_->cols) {
+    throw std::invalid_argument(
+        "SparseMatrix::permutedView: matrix must be square");
+  }
+  return PermutedView(*this);
+}
+
+template <class T, class Index>
+std::size_t BasicSparseMatrix<T, Index>::PermutedView::rows() const noexcept {
+  return base_->impl_->rows;
+}
+
+template <class T, class Index>
+std::size_t BasicSparseMatrix<T, Index>::PermutedView::cols() const noexcept {
+  return base_->impl_->cols;
+}
+
+template <class T, class Index>
+std::span<const Index>
+BasicSparseMatrix<T, Index>::PermutedView::permutation() const {
+  Impl& m = *base_->impl_;
+  m.buildPermuted();
+  return {m.perm.data(), m.perm.size()};
+}
+
+template <class T, class Index>
+void BasicSparseMatrix<T, Index>::PermutedView::spmv(std::span<const T> x,
+                                                     std::span<T> y) const {
+  Impl& m = *base_->impl_;
+  if (x.size() != m.cols || y.size() != m.rows) {
+    throw std::invalid_argument("PermutedView::spmv: shape mismatch");
+  }
+  m.buildPermuted();
+  const std::size_t n = m.rows;
+  // Gather x into permuted order, multiply with the reordered arrays'
+  // near-band locality, scatter the result back to original indices.
+  // Two O(n) passes against O(nnz) of well-localized work.
+  std::vector<T> px(n);
+  std::vector<T> py(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    px[i] = x[m.perm[i]];
+  }
+  spmvKernel<T, Index>()(n, m.prm_row_ptr.data(), m.prm_col_idx.data(),
+                         m.prm_values.data(), px.data(), py.data());
+  for (std::size_t i = 0; i < n; ++i) {
+    y[m.perm[i]] = py[i];
+  }
+}
+
+template <class T, class Index>
+std::vector<T> BasicSparseMatrix<T, Index>::PermutedView::multiply(
+    const std::vector<T>& x) const {
+  std::vector<T> y(base_->impl_->rows, T{});
+  spmv(x, y);
+  return y;
+}
+
+template <class T, class Index>
+std::vector<T> BasicSparseMatrix<T, Index>::multiply(
+    const std::vector<T>& x) const {
+  std::vector<T> y(impl_->rows, T{});
+  spmv(x, y);
+  return y;
+}
+
+namespace {
+
+// Dense bs x bs micro-kernel on a full interior block; the contiguous
+// row-major tile lets the compiler vectorize without gathers.
+template <std::size_t Bs, class T>
+inline void blockKernel(const T* block, const T* x, T* y) {
+  for (std::size_t r = 0; r < Bs; ++r) {
+    T sum{};
+    for (std::size_t c = 0; c < Bs; ++c) {
+      sum += block[r * Bs + c] * x[c];
+    }
+    y[r] += sum;
+  }
+}
+
+// Fixed-length row dot product: the constant trip count is fully
+// unrolled, so the row pays no loop bookkeeping or end-of-row compare
+// per entry.
+template <std::size_t Len, class T, class Index>
+inline T dotFixed(const Index* cols, const T* values, const T* x) {
+  T sum{};
+  for (std::size_t k = 0; k < Len; ++k) {
+    sum += values[k] * x[cols[k]];
+  }
+  return sum;
+}
+
+// Short-row kernel: each row length dispatches through a jump table to
+// a fully unrolled fixed-length dot product. On matrices dominated by
+// rows of fewer than 8 entries this removes the per-entry loop overhead
+// and the poorly predicted end-of-row branch of the generic loop; the
+// occasional longer row falls back to it.
+template <class T, class Index>
+void spmvShortRow(std::size_t rows, const Index* row_ptr,
+                  const Index* col_idx, const T* values, const T* x, T* y) {
+  for (std::size_t i = 0; i < rows; ++i) {
+    const std::size_t k = row_ptr[i];
+    const Index* c = col_idx + k;
+    const T* v = values + k;
+    switch (static_cast<std::size_t>(row_ptr[i + 1]) - k) {
+      case 0:
+        y[i] = T{};
+        break;
+      case 1:
+        y[i] = dotFixed<1, T, Index>(c, v, x);
+        break;
+      case 2:
+        y[i] = dotFixed<2, T, Index>(c, v, x);
+        break;
+      case 3:
+        y[i] = dotFixed<3, T, Index>(c, v, x);
+        break;
+      case 4:
+        y[i] = dotFixed<4, T, Index>(c, v, x);
+        break;
+      case 5:
+        y[i] = dotFixed<5, T, Index>(c, v, x);
+        break;
+      case 6:
+        y[i] = dotFixed<6, T, Index>(c, v, x);
+        break;
+      case 7:
+        y[i] = dotFixed<7, T, Index>(c, v, x);
+        break;
+      default: {
+        T sum{};
+        for (std::size_t j = k; j < row_ptr[i + 1]; ++j) {
+          sum += values[j] * x[col_idx[j]];
+        }
+        y[i] = sum;
+        break;
+      }
+    }
+  }
+}
+
+// Banded kernel: a row whose stored columns are contiguous reads x with
+// unit stride from its first column — no index gather at all — which
+// the compiler vectorizes like a dense dot product. Rows with gaps in
+// the band fall back to the gathered loop.
+template <class T, class Index>
+void spmvBanded(std::size_t rows, const Index* row_ptr, const Index* col_idx,
+                const T* values, const T* x, T* y) {
+  for (std::size_t i = 0; i < rows; ++i) {
+    const std::size_t k = row_ptr[i];
+    const std::size_t end = row_ptr[i + 1];
+    const std::size_t len = end - k;
+    T sum{};
+    if (len != 0 && static_cast<std::size_t>(col_idx[end - 1]) -
+                            static_cast<std::size_t>(col_idx[k]) ==
+                        len - 1) {
+      const T* xs = x + col_idx[k];
+      for (std::size_t j = 0; j < len; ++j) {
+        sum += values[k + j] * xs[j];
+      }
+    } else {
+      for (std::size_t j = k; j < end; ++j) {
+        sum += values[j] * x[col_idx[j]];
+      }
+    }
+    y[i] = sum;
+  }
+}
+
+// Measures row statistics in one O(nnz) pass and picks the kernel the
+// structure deserves: a narrow near-diagonal band with almost all rows
+// contiguous takes the gather-free banded kernel, a matrix dominated by
+// one short row length (average nnz per row below 8, three quarters of
+// the rows sharing a length) the unrolled dispatch, and everything else
+// the generic SIMD/scalar kernel.
+template <class Index>
+SpmvShape classifySpmvShape(std::size_t rows, std::size_t cols,
+                            const Index* row_ptr, const Index* col_idx) {
+  const std::size_t nnz = row_ptr[rows];
+  if (rows == 0 || nnz == 0) {
+    return SpmvShape::kGeneric;
+  }
+  std::size_t contiguousRows = 0;
+  std::size_t maxDeviation = 0;
+  std::size_t lengthHist[8] = {};
+  for (std::size_t i = 0; i < rows; ++i) {
+    const std::size_t k = row_ptr[i];
+    const std::size_t end = row_ptr[i + 1];
+    if (end - k < 8) {
+      ++lengthHist[end - k];
+    }
+    if (k == end) {
+      ++contiguousRows;
+      continue;
+    }
+    for (std::size_t j = k; j < end; ++j) {
+      const std::size_t c = col_idx[j];
+      maxDeviation = std::max(maxDeviation, c > i ? c - i : i - c);
+    }
+    if (static_cast<std::size_t>(col_idx[end - 1]) -
+            static_cast<std::size_t>(col_idx[k]) ==
+        end - k - 1) {
+      ++contiguousRows;
+    }
+  }
+  // The band must be narrow both absolutely and relative to the matrix;
+  // a wide "band" would still pull most of x from far away, at which
+  // point the generic gather kernel is the right tool.
+  const std::size_t bandWidth = 2 * maxDeviation + 1;
+  if (bandWidth <= 64 && bandWidth <= std::max<std::size_t>(cols / 8, 1) &&
+      contiguousRows * 10 >= rows * 9) {
+    return SpmvShape::kBanded;
+  }
+  // Short-row dispatch pays for itself only when the jump table
+  // predicts: require one dominant length, not just a low average —
+  // rows of randomly varying length mispredict every dispatch and lose
+  // to the generic kernel's predictable inner loop.
+  const std::size_t dominantLength =
+      *std::max_element(lengthHist, lengthHist + 8);
+  if (nnz < rows * 8 && dominantLength * 4 >= rows * 3) {
+    return SpmvShape::kShortRow;
+  }
+  return SpmvShape::kGeneric;
+}
+
+}  // namespace
+
+template <class T, class Index>
+void BasicSparseMatrix<T, Index>::spmv(std::span<const T> x,
+                                       std::span<T> y) const {
+  impl_->compactLog();
+  if (x.size() != impl_->cols || y.size() != impl_->rows) {
+    throw std::invalid_argument("SparseMatrix::spmv: shape mismatch");
+  }
+  if (impl_->strip_cols != 0) {
+    // Strip-major pass: each strip confines the x gathers to one
+    // cache-resident window; y is revisited once per strip as a linear
+    // stream that prefetches well.
+    const Impl& m = *impl_;
+    std::fill(y.begin(), y.end(), T{});
+    const std::size_t slab = m.rows + 1;
+    const std::size_t strips = m.strip_row_ptr.size() / slab;
+    for (std::size_t s = 0; s < strips; ++s) {
+      const Index* srp = m.strip_row_ptr.data() + s * slab;
+      for (std::size_t r = 0; r < m.rows; ++r) {
+        T sum{};
+        for (std::size_t k = srp[r]; k < srp[r + 1]; ++k) {
+          sum += m.strip_values[k] * x[m.strip_col_idx[k]];
+        }
+        y[r] += sum;
+      }
+    }
+    return;
+  }
+  if (!impl_->spmv_shape_valid) {
+    impl_->spmv_shape = classifySpmvShape(impl_->rows, impl_->cols,
+                                          impl_->rowPtr(), impl_->colIdx());
+    impl_->spmv_shape_valid = true;
+  }
+  const Impl& m = *impl_;
+  if (m.block_size == 0) {
+    switch (m.spmv_shape) {
+      case SpmvShape::kShortRow:
+        spmvShortRow(m.rows, m.rowPtr(), m.colIdx(), m.vals(), x.data(),
+                     y.data());
+        return;
+      case SpmvShape::kBanded:
+        spmvBanded(m.rows, m.rowPtr(), m.colIdx(), m.vals(), x.data(),
+                   y.data());
+        return;
+      case SpmvShape::kGeneric:
+        break;
+    }
+    spmvKernel<T, Index>()(m.rows, m.rowPtr(), m.colIdx(), m.vals(), x.data(),
+                           y.data());
+    return;
+  }
+
+  const std::size_t bs = m.block_size;
+  const std::size_t blockRows = m.blk_row_ptr.size() - 1;
+  std::fill(y.begin(), y.end(), T{});
+  for (std::size_t bi = 0; bi < blockRows; ++bi) {
+    const std::size_t rh = std::min(bs, m.rows - bi * bs);
+    T* yb = y.data() + bi * bs;
+    for (std::size_t b = m.blk_row_ptr[bi]; b < m.blk_row_ptr[bi + 1]; ++b) {
+      const std::size_t bc = m.blk_col_idx[b];
+      const std::size_t cw = std::min(bs, m.cols - bc * bs);
+      const T* block = m.blk_values.data() + b * bs * bs;
+      const T* xb = x.data() + bc * bs;
+      if (rh == bs && cw == bs) {
+        switch (bs) {
+          case 4:
+            blockKernel<4>(block, xb, yb);
+            continue;
+          case 8:
+            blockKernel<8>(block, xb, yb);
+            continue;
+          default:
+            break;
+        }
+      }
+      for (std::size_t r = 0; r < rh; ++r) {
+        T sum{};
+        for (std::size_t c = 0; c < cw; ++c) {
+          sum += block[r * bs + c] * xb[c];
+        }
+        yb[r] += sum;
+      }
+    }
+  }
+}
+
+template <class T, class Index>
+auto BasicSparseMatrix<T, Index>::rowView(std::size_t row) const -> RowView {
+  impl_->compactLog();
+  if (row >= impl_->rows) {
+    throw std::out_of_range("SparseMatrix::rowView: index out of range");
+  }
+  const std::size_t begin = impl_->rowPtr()[row];
+  const std::size_t end = impl_->rowPtr()[row + 1];
+  return RowView{row,
+                 std::span<const Index>(impl_->colIdx() + begin, end - begin),
+                 std::span<const T>(impl_->vals() + begin, end - begin)};
+}
+
+template <class T, class Index>
+auto BasicSparseMatrix<T, Index>::begin() const noexcept -> const_iterator {
+  impl_->compactLog();
+  return const_iterator(impl_->rowPtr(), impl_->colIdx(), impl_->vals(),
+                        impl_->rows, 0);
+}
+
+template <class T, class Index>
+auto BasicSparseMatrix<T, Index>::end() const noexcept -> const_iterator {
+  impl_->compactLog();
+  return const_iterator(impl_->rowPtr(), impl_->colIdx(), impl_->vals(),
+                        impl_->rows, impl_->count());
+}
+
+template <class T, class Index>
+void BasicSparseMatrix<T, Index>::save(const std::string& path) const {
+  impl_->compactLog();
+  FileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+  header.version = kFileVersion;
+  header.flags = fileFlags<T, Index>();
+  header.rows = impl_->rows;
+  header.cols = impl_->cols;
+  header.nnz = impl_->count();
+
+  FILE* file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    throw std::runtime_error("SparseMatrix::save: cannot open " + path);
+  }
+  const char pad[64] = {};
+  auto writeSection = [&](const void* data, std::size_t bytes) {
+    if (bytes != 0 && std::fwrite(data, 1, bytes, file) != bytes) {
+      std::fclose(file);
+      throw std::runtime_error("SparseMatrix::save: write failed for " + path);
+    }
+    const std::size_t padding = alignUp64(bytes) - bytes;
+    if (padding != 0 && std::fwrite(pad, 1, padding, file) != padding) {
+      std::fclose(file);
+      throw std::runtime_error("SparseMatrix::save: write failed for " + path);
+    }
+  };
+  writeSection(&header, sizeof(header));
+  writeSection(impl_->rowPtr(), (impl_->rows + 1) * sizeof(Index));
+  writeSection(impl_->colIdx(), impl_->count() * sizeof(Index));
+  writeSection(impl_->vals(), impl_->count() * sizeof(T));
+  if (std::fclose(file) != 0) {
+    throw std::runtime_error("SparseMatrix::save: close failed for " + path);
+  }
+}
+
+template <class T, class Index>
+BasicSparseMatrix<T, Index> BasicSparseMatrix<T, Index>::open(
+    const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("SparseMatrix::open: cannot open " + path);
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error("SparseMatrix::open: stat failed for " + path);
+  }
+  const std::size_t fileSize = static_cast<std::size_t>(st.st_size);
+  if (fileSize < sizeof(FileHeader)) {
+    ::close(fd);
+    throw std::runtime_error("SparseMatrix::open: truncated file " + path);
+  }
+  void* map = ::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);  // the mapping keeps its own reference
+  if (map == MAP_FAILED) {
+    throw std::runtime_error("SparseMatrix::open: mmap failed for " + path);
+  }
+
+  const auto* header = static_cast<const FileHeader*>(map);
+  const auto* base = static_cast<const char*>(map);
+  if (std::memcmp(header->magic, kFileMagic, sizeof(kFileMagic)) != 0 ||
+      header->version != kFileVersion) {
+    ::munmap(map, fileSize);
+    throw std::runtime_error("SparseMatrix::open: bad header in " + path);
+  }
+  if (header->flags != fileFlags<T, Index>()) {
+    ::munmap(map, fileSize);
+    throw std::runtime_error(
+        "SparseMatrix::open: element/index type mismatch in " + path);
+  }
+  const std::size_t rowPtrOffset = sizeof(FileHeader);
+  const std::size_t colIdxOffset =
+      rowPtrOffset + alignUp64((header->rows + 1) * sizeof(Index));
+  const std::size_t valuesOffset =
+      colIdxOffset + alignUp64(header->nnz * sizeof(Index));
+  if (valuesOffset + header->nnz * sizeof(T) > fileSize) {
+    ::munmap(map, fileSize);
+    throw std::runtime_error("SparseMatrix::open: truncated file " + path);
+  }
+
+  BasicSparseMatrix result(header->rows, header->cols);
+  Impl& out = *result.impl_;
+  out.row_ptr.clear();
+  out.row_ptr.shrink_to_fit();
+  out.map = map;
+  out.map_size = fileSize;
+  out.map_nnz = header->nnz;
+  out.map_row_ptr = reinterpret_cast<const Index*>(base + rowPtrOffset);
+  out.map_col_idx = reinterpret_cast<const Index*>(base + colIdxOffset);
+  out.map_values = reinterpret_cast<const T*>(base + valuesOffset);
+  return result;
+}
+
+template <class T, class Index>
+BasicStreamingMatrix<T, Index> BasicStreamingMatrix<T, Index>::open(
+    const std::string& path, std::size_t panelBytes) {
+  if (panelBytes == 0) {
+    panelBytes = std::size_t{32} << 20;
+  }
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("StreamingMatrix::open: cannot open " + path);
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error("StreamingMatrix::open: stat failed for " + path);
+  }
+  const std::size_t fileSize = static_cast<std::size_t>(st.st_size);
+
+  FileHeader header;
+  if (fileSize < sizeof(header) ||
+      !preadFull(fd, &header, sizeof(header), 0)) {
+    ::close(fd);
+    throw std::runtime_error("StreamingMatrix::open: truncated file " + path);
+  }
+  if (std::memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0 ||
+      header.version != kFileVersion) {
+    ::close(fd);
+    throw std::runtime_error("StreamingMatrix::open: bad header in " + path);
+  }
+  if (header.flags != fileFlags<T, Index>()) {
+    ::close(fd);
+    throw std::runtime_error(
+        "StreamingMatrix::open: element/index type mismatch in " + path);
+  }
+
+  BasicStreamingMatrix result;
+  result.fd_ = fd;
+  result.rows_ = header.rows;
+  result.cols_ = header.cols;
+  result.nnz_ = header.nnz;
+  const std::size_t rowPtrOffset = sizeof(FileHeader);
+  result.col_idx_offset_ =
+      rowPtrOffset + alignUp64((result.rows_ + 1) * sizeof(Index));
+  result.values_offset_ =
+      result.col_idx_offset_ + alignUp64(result.nnz_ * sizeof(Index));
+  if (result.values_offset_ + result.nnz_ * sizeof(T) > fileSize) {
+    throw std::runtime_error("StreamingMatrix::open: truncated file " + path);
+  }
+
+  // Only the row pointers live in memory for the matrix's lifetime.
+  result.row_ptr_.resize(result.rows_ + 1);
+  if (!preadFull(fd, result.row_ptr_.data(),
+                 (result.rows_ + 1) * sizeof(Index), rowPtrOffset)) {
+    throw std::runtime_error("StreamingMatrix::open: read failed for " + path);
+  }
+
+  // Cut panels by stored-entry budget so heavy rows do not starve the
+  // overlap; a single row larger than the budget gets a panel to itself.
+  const std::size_t bytesPerEntry = sizeof(Index) + sizeof(T);
+  const std::size_t budget = std::max<std::size_t>(panelBytes / bytesPerEntry,
+                                                   1);
+  result.panel_rows_.push_back(0);
+  std::size_t begin = 0;
+  for (std::size_t r = 0; r < result.rows_; ++r) {
+    const std::size_t spanned = result.row_ptr_[r + 1] - result.row_ptr_[begin];
+    if (spanned > budget && r > begin) {
+      result.panel_rows_.push_back(r);
+      begin = r;
+    }
+  }
+  if (result.rows_ != 0) {
+    result.panel_rows_.push_back(result.rows_);
+  }
+  for (std::size_t p = 0; p + 1 < result.panel_rows_.size(); ++p) {
+    const std::size_t entries = result.row_ptr_[result.panel_rows_[p + 1]] -
+                                result.row_ptr_[result.panel_rows_[p]];
+    result.max_panel_entries_ = std::max(result.max_panel_entries_, entries);
+  }
+  return result;
+}
+
+template <class T, class Index>
+BasicStreamingMatrix<T, Index>::~BasicStreamingMatrix() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+template <class T, class Index>
+BasicStreamingMatrix<T, Index>::BasicStreamingMatrix(
+    BasicStreamingMatrix&& other) noexcept
+    : fd_(std::exchange(other.fd_, -1)),
+      rows_(other.rows_),
+      cols_(other.cols_),
+      nnz_(other.nnz_),
+      col_idx_offset_(other.col_idx_offset_),
+      values_offset_(other.values_offset_),
+      row_ptr_(std::move(other.row_ptr_)),
+      panel_rows_(std::move(other.panel_rows_)),
+      max_panel_entries_(other.max_panel_entries_) {}
+
+template <class T, class Index>
+BasicStreamingMatrix<T, Index>& BasicStreamingMatrix<T, Index>::operator=(
+    BasicStreamingMatrix&& other) noexcept {
+  if (this != &other) {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+    fd_ = std::exchange(other.fd_, -1);
+    rows_ = other.rows_;
+    cols_ = other.cols_;
+    nnz_ = other.nnz_;
+    col_idx_offset_ = other.col_idx_offset_;
+    values_offset_ = other.values_offset_;
+    row_ptr_ = std::move(other.row_ptr_);
+    panel_rows_ = std::move(other.panel_rows_);
+    max_panel_entries_ = other.max_panel_entries_;
+  }
+  return *this;
+}
+
+template <class T, class Index>
+void BasicStreamingMatrix<T, Index>::spmv(std::span<const T> x,
+                                          std::span<T> y) const {
+  if (x.size() != cols_ || y.size() != rows_) {
+    throw std::invalid_argument("StreamingMatrix::spmv: shape mismatch");
+  }
+  std::fill(y.begin(), y.end(), T{});
+  const std::size_t panels =
+      panel_rows_.size() < 2 ? 0 : panel_rows_.size() - 1;
+  if (panels == 0) {
+    return;
+  }
+
+  // Double buffer: the prefetch thread fills `back` for panel p + 1 with
+  // positioned reads while the caller's thread multiplies `front`. A
+  // plain thread per panel keeps this portable; the pipeline is the same
+  // one-panel-deep overlap an async I/O ring would give here, and the
+  // spawn cost is noise next to a multi-megabyte read.
+  struct Buffer {
+    std::vector<Index> col_idx;
+    std::vector<T> values;
+    bool ok = true;
+  };
+  Buffer front, back;
+  front.col_idx.resize(max_panel_entries_);
+  front.values.resize(max_panel_entries_);
+  back.col_idx.resize(max_panel_entries_);
+  back.values.resize(max_panel_entries_);
+
+  auto readPanel = [this](std::size_t p, Buffer& buf) {
+    const std::size_t kBegin = row_ptr_[panel_rows_[p]];
+    const std::size_t entries = row_ptr_[panel_rows_[p + 1]] - kBegin;
+    buf.ok =
+        preadFull(fd_, buf.col_idx.data(), entries * sizeof(Index),
+                  col_idx_offset_ + kBegin * sizeof(Index)) &&
+        preadFull(fd_, buf.values.data(), entries * sizeof(T),
+                  values_offset_ + kBegin * sizeof(T));
+  };
+
+  readPanel(0, front);
+  std::vector<Index> panelRowPtr;
+  for (std::size_t p = 0; p < panels; ++p) {
+    std::thread prefetch;
+    if (p + 1 < panels) {
+      prefetch = std::thread(readPanel, p + 1, std::ref(back));
+    }
+    if (!front.ok) {
+      if (prefetch.joinable()) {
+        prefetch.join();
+      }
+      throw std::runtime_error("StreamingMatrix::spmv: read failed");
+    }
+    // Rebase the panel's row pointers onto the buffer before handing the
+    // flat kernel a dense CSR slice.
+    const std::size_t rowBegin = panel_rows_[p];
+    const std::size_t rowEnd = panel_rows_[p + 1];
+    const std::size_t kBegin = row_ptr_[rowBegin];
+    panelRowPtr.resize(rowEnd - rowBegin + 1);
+    for (std::size_t r = rowBegin; r <= rowEnd; ++r) {
+      panelRowPtr[r - rowBegin] = static_cast<Index>(row_ptr_[r] - kBegin);
+    }
+    spmvKernel<T, Index>()(rowEnd - rowBegin, panelRowPtr.data(),
+                           front.col_idx.data(), front.values.data(), x.data(),
+                           y.data() + rowBegin);
+    if (prefetch.joinable()) {
+      prefetch.join();
+    }
+    std::swap(front, back);
+  }
+}
+
+template <class T, class Index>
+std::vector<T> BasicStreamingMatrix<T, Index>::multiply(
+    const std::vector<T>& x) const {
+  std::vector<T> y(rows_, T{});
+  spmv(x, y);
+  return y;
+}
+
+// The pimpl keeps every member definition in this translation unit; only
+// the combinations instantiated below link.
+template class BasicSparseMatrix<double, std::size_t>;
+template class BasicSparseMatrix<float, std::size_t>;
+template class BasicSparseMatrix<double, std::uint32_t>;
+template class BasicSparseMatrix<float, std::uint32_t>;
+
+template class BasicStreamingMatrix<double, std::size_t>;
+template class BasicStreamingMatrix<float, std::size_t>;
+template class BasicStreamingMatrix<double, std::uint32_t>;
+template class BasicStreamingMatrix<float, std::uint32_t>;
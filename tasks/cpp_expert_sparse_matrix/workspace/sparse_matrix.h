@@ -2,24 +2,560 @@
 #define SPARSE_MATRIX_H
 
 #include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
 
-class SparseMatrix {
+template <class T, class Index>
+class SpmvTerm;
+
+// Sparse matrix over an arbitrary element type T (float halves memory
+// traffic and doubles effective SIMD width versus double) and storage
+// index type Index (std::uint32_t shrinks the index arrays by half for
+// matrices under 2^32 stored entries). Coordinates in the public API
+// stay std::size_t regardless of Index. Member definitions live in
+// sparse_matrix.cpp; the supported instantiations are (double, float)
+// x (std::size_t, std::uint32_t).
+template <class T = double, class Index = std::size_t>
+class BasicSparseMatrix {
  public:
-  SparseMatrix(std::size_t rows, std::size_t cols);
+  struct Triplet {
+    std::size_t row;
+    std::size_t col;
+    T value;
+  };
+
+  enum class DuplicatePolicy { kSum, kOverwrite };
+
+  BasicSparseMatrix(std::size_t rows, std::size_t cols);
+  ~BasicSparseMatrix();
+
+  // Moves steal the pimpl pointer; copies share it copy-on-write behind
+  // an atomic reference count, so containers of matrices relocate and
+  // copy in O(1). The first mutation of a shared matrix detaches it onto
+  // its own deep copy.
+  BasicSparseMatrix(BasicSparseMatrix&& other) noexcept;
+  BasicSparseMatrix& operator=(BasicSparseMatrix&& other) noexcept;
+  BasicSparseMatrix(const BasicSparseMatrix& other) noexcept;
+  BasicSparseMatrix& operator=(const BasicSparseMatrix& other) noexcept;
+
+  // Builds a matrix from unsorted (row, col, value) entries: a parallel
+  // sort followed by one O(nnz) pass that folds duplicates (summing or
+  // keeping the last write), drops exact zeros, and emits the CSR arrays.
+  // Far cheaper than repeated set() for bulk ingestion.
+  static BasicSparseMatrix fromTriplets(
+      std::size_t rows, std::size_t cols, std::vector<Triplet>&& triplets,
+      DuplicatePolicy policy = DuplicatePolicy::kSum);
 
   std::size_t rows() const noexcept;
   std::size_t cols() const noexcept;
   std::size_t nnz() const noexcept;
 
-  double get(std::size_t row, std::size_t col) const;
-  void set(std::size_t row, std::size_t col, double value);
+  T get(std::size_t row, std::size_t col) const;
+  void set(std::size_t row, std::size_t col, T value);
+
+  // set() buffers updates in a small sorted delta log instead of
+  // restructuring the CSR arrays on every call; get() and nnz() consult
+  // log + CSR. compact() folds the log into the CSR arrays in one
+  // O(nnz + k) pass and also runs automatically when the log reaches an
+  // internal threshold or a structural operation (transpose, multiply,
+  // spmv, save, ...) needs flat arrays.
+  void compact();
+
+  // Chunked bump allocator that operations borrow scratch storage from
+  // (dense accumulators, touched-column lists, scatter offsets), so hot
+  // loops stop hitting the global allocator. reset() reclaims everything
+  // at once — typically called between solver iterations — while keeping
+  // the chunks for reuse.
+  class Arena {
+   public:
+    explicit Arena(std::size_t chunkBytes = std::size_t{1} << 20);
+    ~Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(std::size_t bytes, std::size_t alignment);
+    void reset() noexcept;
+
+    template <class U>
+    U* allocate(std::size_t count) {
+      return static_cast<U*>(allocate(count * sizeof(U), alignof(U)));
+    }
+
+   private:
+    std::vector<std::pair<char*, std::size_t>> chunks_;  // base, capacity
+    std::size_t current_ = 0;
+    std::size_t offset_ = 0;
+    std::size_t chunk_bytes_;
+  };
+
+  BasicSparseMatrix transpose() const;
+  BasicSparseMatrix multiply(const BasicSparseMatrix& rhs) const;
+
+  // Arena-backed variants: identical results, but all temporary scratch
+  // comes from the arena instead of malloc.
+  BasicSparseMatrix transpose(Arena& arena) const;
+  BasicSparseMatrix multiply(const BasicSparseMatrix& rhs,
+                             Arena& arena) const;
+
+  // Gustavson SpGEMM with output rows partitioned across worker threads,
+  // each using its own dense accumulator; the per-thread results are
+  // concatenated into the final CSR arrays. numThreads == 0 uses
+  // std::thread::hardware_concurrency().
+  BasicSparseMatrix multiplyParallel(const BasicSparseMatrix& rhs,
+                                     std::size_t numThreads = 0) const;
+
+  // Parallel transpose over contiguous input-row ranges: a first pass
+  // histograms column counts per worker, a serial combine turns the
+  // per-worker counts into disjoint scatter ranges, and a second pass
+  // scatters indices and values with no atomics on the hot path. Output
+  // rows come out sorted because workers own ascending row ranges.
+  // numThreads == 0 uses std::thread::hardware_concurrency().
+  BasicSparseMatrix transposeParallel(std::size_t numThreads = 0) const;
+
+  // Zero-copy view of one row: spans directly over the CSR column-index
+  // and value arrays, valid until the matrix is mutated or destroyed.
+  struct RowView {
+    std::size_t row;
+    std::span<const Index> cols;
+    std::span<const T> values;
+  };
+
+  struct Entry {
+    std::size_t row;
+    std::size_t col;
+    T value;
+  };
+
+  // Forward iterator streaming all stored (row, col, value) entries in
+  // CSR order without per-entry binary searches.
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Entry;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Entry*;
+    using reference = Entry;
+
+    const_iterator() = default;
+
+    Entry operator*() const {
+      return Entry{row_, col_idx_[k_], values_[k_]};
+    }
+
+    const_iterator& operator++() {
+      ++k_;
+      while (row_ < rows_ && k_ >= row_ptr_[row_ + 1]) {
+        ++row_;
+      }
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    friend bool operator==(const const_iterator& a, const const_iterator& b) {
+      return a.k_ == b.k_;
+    }
+
+   private:
+    friend class BasicSparseMatrix<T, Index>;
+    const_iterator(const Index* row_ptr, const Index* col_idx,
+                   const T* values, std::size_t rows, std::size_t k)
+        : row_ptr_(row_ptr), col_idx_(col_idx), values_(values), rows_(rows),
+          k_(k) {
+      while (row_ < rows_ && k_ >= row_ptr_[row_ + 1]) {
+        ++row_;
+      }
+    }
+
+    const Index* row_ptr_ = nullptr;
+    const Index* col_idx_ = nullptr;
+    const T* values_ = nullptr;
+    std::size_t rows_ = 0;
+    std::size_t row_ = 0;
+    std::size_t k_ = 0;
+  };
+
+  RowView rowView(std::size_t row) const;
+  const_iterator begin() const noexcept;
+  const_iterator end() const noexcept;
+
+  // Versioned binary persistence. save() writes a 64-byte header followed
+  // by the raw CSR arrays, each section 64-byte aligned; open() maps the
+  // file read-only and serves get/transpose/multiply/spmv straight from
+  // the mapped pages with no deserialization. A mapped matrix copies its
+  // arrays into owned storage on first mutation. The header records the
+  // element and index types, and open() rejects a file whose types do not
+  // match this instantiation.
+  void save(const std::string& path) const;
+  static BasicSparseMatrix open(const std::string& path);
 
-  SparseMatrix transpose() const;
-  SparseMatrix multiply(const SparseMatrix& rhs) const;
+  // Two-phase SpGEMM for solvers that multiply the same pair of sparsity
+  // patterns repeatedly: planMultiply() runs the symbolic phase once
+  // (output row pointers and sorted column indices); execute() refills
+  // only the values. Both operands must keep the sparsity patterns they
+  // had at planning time; entries that cancel numerically remain in the
+  // cached pattern as stored zeros.
+  class MultiplyPlan {
+   public:
+    void execute(const BasicSparseMatrix& a, const BasicSparseMatrix& b,
+                 BasicSparseMatrix& c) const;
+
+   private:
+    friend class BasicSparseMatrix<T, Index>;
+    std::size_t rows_ = 0;
+    std::size_t inner_ = 0;
+    std::size_t cols_ = 0;
+    std::vector<Index> row_ptr_;
+    std::vector<Index> col_idx_;
+  };
+
+  MultiplyPlan planMultiply(const BasicSparseMatrix& rhs) const;
+
+  // Lightweight transposed view: no data is copied. Its spmv/multiply
+  // compute A^T * x over a lazily-built CSC companion index that is
+  // cached inside the matrix and reused until the next mutation, so
+  // repeated A^T products cost one O(nnz) build instead of a transpose
+  // copy per call. The view is valid while the matrix it came from is.
+  class TransposedView {
+   public:
+    std::size_t rows() const noexcept;
+    std::size_t cols() const noexcept;
+    std::vector<T> multiply(const std::vector<T>& x) const;
+    void spmv(std::span<const T> x, std::span<T> y) const;
+
+   private:
+    friend class BasicSparseMatrix<T, Index>;
+    explicit TransposedView(const BasicSparseMatrix& base) : base_(&base) {}
+    const BasicSparseMatrix* base_;
+  };
+
+  TransposedView transposedView() const;
+
+  // Bandwidth-reducing reordered view for square matrices. The first
+  // use computes a reverse Cuthill-McKee permutation of the symmetrized
+  // sparsity pattern and caches the permuted matrix inside this one
+  // (invalidated by mutation, like the CSC companion). spmv()/multiply()
+  // take x and produce y in the original index space: the view gathers
+  // x through the permutation, multiplies with the reordered matrix's
+  // near-band locality, and scatters the result back. permutation()[i]
+  // is the original index placed at permuted position i. The view is
+  // valid while the matrix it came from is.
+  class PermutedView {
+   public:
+    std::size_t rows() const noexcept;
+    std::size_t cols() const noexcept;
+    std::vector<T> multiply(const std::vector<T>& x) const;
+    void spmv(std::span<const T> x, std::span<T> y) const;
+    std::span<const Index> permutation() const;
+
+   private:
+    friend class BasicSparseMatrix<T, Index>;
+    explicit PermutedView(const BasicSparseMatrix& base) : base_(&base) {}
+    const BasicSparseMatrix* base_;
+  };
+
+  PermutedView permutedView() const;
+
+  // Builds a block-sparse (BSR) companion of the matrix with dense
+  // blockSize x blockSize blocks (1..16; FEM workloads typically want 4
+  // or 8). While present, spmv()/multiply(x) run on the contiguous
+  // blocks with unrolled micro-kernels instead of gathering per scalar.
+  // Any mutation drops the blocked storage; rebuild it with toBlocked().
+  void toBlocked(std::size_t blockSize);
+  std::size_t blockSize() const noexcept;  // 0 when not blocked
+
+  // Cache-blocked companion for matrices whose column accesses wander
+  // the whole width of x (power-law graphs thrash the LLC this way):
+  // the CSR entries are repartitioned into vertical strips of stripCols
+  // columns, each strip scanned like a narrow CSR matrix, so the window
+  // of x a strip gathers from stays cache-resident. 0 sizes the window
+  // to 256 KiB of x, half a typical L2 share. Replaces an existing
+  // toBlocked() companion and vice versa; any mutation drops it.
+  void toColumnStrips(std::size_t stripCols = 0);
+  std::size_t stripCols() const noexcept;  // 0 when not stripped
+
+  // Matrix-vector product y = A * x. The span overload writes into caller
+  // storage with no allocation. The inner loop is specialized by shape:
+  // row statistics measured once per structure change pick an unrolled
+  // short-row kernel, a gather-free near-diagonal banded kernel, or the
+  // generic kernel, which itself dispatches at runtime to an AVX-512 or
+  // AVX2 gather path when the CPU and instantiation support it, falling
+  // back to scalar.
+  std::vector<T> multiply(const std::vector<T>& x) const;
+  void spmv(std::span<const T> x, std::span<T> y) const;
 
  private:
+  friend class SpmvTerm<T, Index>;
+
+  void detach();
+
+  // Raw CSR pointers for the expression templates; compacts the delta
+  // log first so the pointers cover the full content.
+  const Index* rawRowPtr() const;
+  const Index* rawColIdx() const;
+  const T* rawValues() const;
+
+  BasicSparseMatrix transposeWithScratch(std::size_t* offset) const;
+  BasicSparseMatrix multiplyWithScratch(const BasicSparseMatrix& rhs, T* acc,
+                                        std::size_t* touched,
+                                        std::size_t* marker) const;
+
   struct Impl;
   Impl* impl_;
 };
 
+using SparseMatrix = BasicSparseMatrix<double, std::size_t>;
+
+// ---------------------------------------------------------------------------
+// Lazy vector expressions. `A * x`, `beta * y` and their sums build small
+// expression objects instead of materializing temporaries; evaluation is
+// one fused element-wise pass. assignTo() is the zero-allocation form:
+//
+//   (A * x + beta * y).assignTo(y);   // y = A*x + beta*y, one pass
+//   auto r = (b - A * x).eval();      // residual into a fresh vector
+//
+// Element-wise terms (`beta * y`, `b`) may alias the destination: index i
+// is read before it is written. The vector multiplied by a matrix must
+// not alias the destination, and the operands must outlive the
+// expression — evaluate within the statement that built it.
+// ---------------------------------------------------------------------------
+
+template <class Derived>
+struct VecExpr {
+  const Derived& derived() const noexcept {
+    return static_cast<const Derived&>(*this);
+  }
+
+  auto eval() const {
+    const Derived& e = derived();
+    std::vector<typename Derived::value_type> y(e.size());
+    for (std::size_t i = 0; i < y.size(); ++i) {
+      y[i] = e[i];
+    }
+    return y;
+  }
+
+  template <class U>
+  void assignTo(std::span<U> y) const {
+    const Derived& e = derived();
+    if (y.size() != e.size()) {
+      throw std::invalid_argument("VecExpr::assignTo: shape mismatch");
+    }
+    for (std::size_t i = 0; i < y.size(); ++i) {
+      y[i] = e[i];
+    }
+  }
+
+  template <class U>
+  void assignTo(std::vector<U>& y) const {
+    assignTo(std::span<U>(y));
+  }
+};
+
+// One output element of A * x: the dot product of row i with x, computed
+// straight off the CSR arrays.
+template <class T, class Index>
+class SpmvTerm : public VecExpr<SpmvTerm<T, Index>> {
+ public:
+  using value_type = T;
+
+  SpmvTerm(const BasicSparseMatrix<T, Index>& m, const std::vector<T>& x)
+      : row_ptr_(m.rawRowPtr()),
+        col_idx_(m.rawColIdx()),
+        values_(m.rawValues()),
+        x_(x.data()),
+        rows_(m.rows()) {
+    if (x.size() != m.cols()) {
+      throw std::invalid_argument("SpmvTerm: shape mismatch");
+    }
+  }
+
+  std::size_t size() const noexcept { return rows_; }
+
+  T operator[](std::size_t i) const {
+    T sum{};
+    for (std::size_t k = row_ptr_[i]; k < row_ptr_[i + 1]; ++k) {
+      sum += values_[k] * x_[col_idx_[k]];
+    }
+    return sum;
+  }
+
+ private:
+  const Index* row_ptr_;
+  const Index* col_idx_;
+  const T* values_;
+  const T* x_;
+  std::size_t rows_;
+};
+
+template <class T>
+class VecRef : public VecExpr<VecRef<T>> {
+ public:
+  using value_type = T;
+
+  explicit VecRef(const std::vector<T>& v) : data_(v.data()), n_(v.size()) {}
+
+  std::size_t size() const noexcept { return n_; }
+  T operator[](std::size_t i) const { return data_[i]; }
+
+ private:
+  const T* data_;
+  std::size_t n_;
+};
+
+template <class E>
+class ScaledExpr : public VecExpr<ScaledExpr<E>> {
+ public:
+  using value_type = typename E::value_type;
+
+  ScaledExpr(value_type scale, E expr) : scale_(scale), expr_(expr) {}
+
+  std::size_t size() const noexcept { return expr_.size(); }
+  value_type operator[](std::size_t i) const { return scale_ * expr_[i]; }
+
+ private:
+  value_type scale_;
+  E expr_;
+};
+
+template <class L, class R>
+class VecSum : public VecExpr<VecSum<L, R>> {
+ public:
+  using value_type = typename L::value_type;
+
+  VecSum(L lhs, R rhs) : lhs_(lhs), rhs_(rhs) {
+    if (lhs_.size() != rhs_.size()) {
+      throw std::invalid_argument("VecSum: shape mismatch");
+    }
+  }
+
+  std::size_t size() const noexcept { return lhs_.size(); }
+  value_type operator[](std::size_t i) const { return lhs_[i] + rhs_[i]; }
+
+ private:
+  L lhs_;
+  R rhs_;
+};
+
+template <class L, class R>
+class VecDiff : public VecExpr<VecDiff<L, R>> {
+ public:
+  using value_type = typename L::value_type;
+
+  VecDiff(L lhs, R rhs) : lhs_(lhs), rhs_(rhs) {
+    if (lhs_.size() != rhs_.size()) {
+      throw std::invalid_argument("VecDiff: shape mismatch");
+    }
+  }
+
+  std::size_t size() const noexcept { return lhs_.size(); }
+  value_type operator[](std::size_t i) const { return lhs_[i] - rhs_[i]; }
+
+ private:
+  L lhs_;
+  R rhs_;
+};
+
+template <class T, class Index>
+SpmvTerm<T, Index> operator*(const BasicSparseMatrix<T, Index>& m,
+                             const std::vector<T>& x) {
+  return SpmvTerm<T, Index>(m, x);
+}
+
+template <class T>
+  requires std::is_arithmetic_v<T>
+ScaledExpr<VecRef<T>> operator*(T scale, const std::vector<T>& v) {
+  return ScaledExpr<VecRef<T>>(scale, VecRef<T>(v));
+}
+
+template <class D>
+ScaledExpr<D> operator*(typename D::value_type scale, const VecExpr<D>& e) {
+  return ScaledExpr<D>(scale, e.derived());
+}
+
+template <class L, class R>
+VecSum<L, R> operator+(const VecExpr<L>& l, const VecExpr<R>& r) {
+  return VecSum<L, R>(l.derived(), r.derived());
+}
+
+template <class L, class T>
+VecSum<L, VecRef<T>> operator+(const VecExpr<L>& l, const std::vector<T>& r) {
+  return VecSum<L, VecRef<T>>(l.derived(), VecRef<T>(r));
+}
+
+template <class T, class R>
+VecSum<VecRef<T>, R> operator+(const std::vector<T>& l, const VecExpr<R>& r) {
+  return VecSum<VecRef<T>, R>(VecRef<T>(l), r.derived());
+}
+
+template <class L, class R>
+VecDiff<L, R> operator-(const VecExpr<L>& l, const VecExpr<R>& r) {
+  return VecDiff<L, R>(l.derived(), r.derived());
+}
+
+template <class L, class T>
+VecDiff<L, VecRef<T>> operator-(const VecExpr<L>& l, const std::vector<T>& r) {
+  return VecDiff<L, VecRef<T>>(l.derived(), VecRef<T>(r));
+}
+
+template <class T, class R>
+VecDiff<VecRef<T>, R> operator-(const std::vector<T>& l, const VecExpr<R>& r) {
+  return VecDiff<VecRef<T>, R>(VecRef<T>(l), r.derived());
+}
+
+// Out-of-core SpMV over a matrix saved by BasicSparseMatrix::save() that
+// is too large to map or load. Only the row-pointer array is held in
+// memory; the column-index and value sections are streamed through two
+// panel buffers, with the next panel's positioned reads running on a
+// prefetch thread while the current panel multiplies, so I/O and compute
+// overlap one panel deep. Panels are cut by entry count, not row count,
+// to keep I/O sizes even on skewed degree distributions. The element and
+// index types must match the file, exactly as with open().
+template <class T = double, class Index = std::size_t>
+class BasicStreamingMatrix {
+ public:
+  // panelBytes bounds one panel buffer (column indices plus values);
+  // 0 picks a default of 32 MiB. Two buffers of that size are live
+  // during spmv().
+  static BasicStreamingMatrix open(const std::string& path,
+                                   std::size_t panelBytes = 0);
+  ~BasicStreamingMatrix();
+
+  BasicStreamingMatrix(BasicStreamingMatrix&& other) noexcept;
+  BasicStreamingMatrix& operator=(BasicStreamingMatrix&& other) noexcept;
+  BasicStreamingMatrix(const BasicStreamingMatrix&) = delete;
+  BasicStreamingMatrix& operator=(const BasicStreamingMatrix&) = delete;
+
+  std::size_t rows() const noexcept { return rows_; }
+  std::size_t cols() const noexcept { return cols_; }
+  std::size_t nnz() const noexcept { return nnz_; }
+
+  std::vector<T> multiply(const std::vector<T>& x) const;
+  void spmv(std::span<const T> x, std::span<T> y) const;
+
+ private:
+  BasicStreamingMatrix() = default;
+
+  int fd_ = -1;
+  std::size_t rows_ = 0;
+  std::size_t cols_ = 0;
+  std::size_t nnz_ = 0;
+  std::size_t col_idx_offset_ = 0;
+  std::size_t values_offset_ = 0;
+  std::vector<Index> row_ptr_;
+  std::vector<std::size_t> panel_rows_;  // panel boundaries, panels + 1
+  std::size_t max_panel_entries_ = 0;
+};
+
+using StreamingMatrix = BasicStreamingMatrix<double, std::size_t>;
+
 #endif
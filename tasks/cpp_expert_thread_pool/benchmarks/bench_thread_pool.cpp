@@ -0,0 +1,158 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Self-contained microbenchmark driver for the pool: warmup passes, a
+// handful of timed repetitions, and machine-readable JSON on stdout so
+// successive runs can be diffed commit to commit. No external deps.
+namespace {
+
+inline std::uint64_t nowNs() {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+template <class T>
+inline void doNotOptimize(const T& value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+bool firstRecord = true;
+
+void emitRecord(const std::string& name, std::uint64_t samples,
+                double minNs, double medianNs, double p99Ns) {
+  std::printf("%s  {\"name\": \"%s\", \"samples\": %llu, "
+              "\"ns_per_op_min\": %.2f, \"ns_per_op_median\": %.2f, "
+              "\"ns_per_op_p99\": %.2f, \"ops_per_sec\": %.0f}",
+              firstRecord ? "" : ",\n", name.c_str(),
+              static_cast<unsigned long long>(samples), minNs, medianNs,
+              p99Ns, 1e9 / medianNs);
+  firstRecord = false;
+  std::fflush(stdout);
+}
+
+// Times `fn` (one call = `opsPerCall` tasks) over warmup + measured
+// repetitions and reports per-task figures.
+template <class Fn>
+void runThroughput(const std::string& name, std::size_t opsPerCall,
+                   Fn&& fn) {
+  constexpr int kWarmup = 2;
+  constexpr int kRepetitions = 5;
+  std::vector<double> nsPerOp;
+  for (int rep = 0; rep < kWarmup + kRepetitions; ++rep) {
+    const std::uint64_t start = nowNs();
+    fn();
+    const std::uint64_t elapsed = nowNs() - start;
+    if (rep >= kWarmup) {
+      nsPerOp.push_back(static_cast<double>(elapsed) / opsPerCall);
+    }
+  }
+  std::sort(nsPerOp.begin(), nsPerOp.end());
+  emitRecord(name, opsPerCall * kRepetitions, nsPerOp.front(),
+             nsPerOp[nsPerOp.size() / 2], nsPerOp.back());
+}
+
+std::string label(const char* op, std::size_t workers) {
+  char buf[64];
+  std::snprintf(buf, sizeof(buf), "%s/workers=%zu", op, workers);
+  return buf;
+}
+
+// Fire-and-forget throughput: how fast empty tasks move through the
+// pool, submission and completion included.
+void benchTaskThroughput(std::size_t workers) {
+  constexpr std::size_t kTasks = 8192;
+  ThreadPool pool(workers);
+  TaskGroup group(pool);
+  runThroughput(label("throughput", workers), kTasks, [&]() {
+    std::atomic<std::uint64_t> sink{0};
+    for (std::size_t i = 0; i < kTasks; ++i) {
+      group.spawn([&sink]() {
+        sink.fetch_add(1, std::memory_order_relaxed);
+      });
+    }
+    group.wait();
+    doNotOptimize(sink.load());
+  });
+}
+
+// parallel_for over a trivial body: measures strip-mining and join
+// overhead per element.
+void benchParallelFor(std::size_t workers) {
+  constexpr std::size_t kElements = 1 << 16;
+  ThreadPool pool(workers);
+  std::vector<std::uint64_t> data(kElements, 0);
+  runThroughput(label("parallel_for", workers), kElements, [&]() {
+    pool.parallel_for(std::size_t{0}, kElements, 0,
+                      [&](std::size_t i) { data[i] += 1; });
+    doNotOptimize(data[0]);
+  });
+}
+
+// Round-trip latency under producer contention: each producer thread
+// repeatedly does enqueue(...).get() and records the wall time of the
+// round trip; distributions are merged across producers.
+void benchLatencyUnderContention(std::size_t workers,
+                                 std::size_t producers) {
+  constexpr std::size_t kSamplesPerProducer = 1000;
+  ThreadPool pool(workers);
+
+  // Warmup pass so worker threads are awake and caches primed.
+  for (int i = 0; i < 256; ++i) {
+    pool.enqueue([]() {}).get();
+  }
+
+  std::vector<std::vector<double>> perProducer(producers);
+  std::vector<std::thread> threads;
+  for (std::size_t p = 0; p < producers; ++p) {
+    threads.emplace_back([&pool, &perProducer, p]() {
+      auto& samples = perProducer[p];
+      samples.reserve(kSamplesPerProducer);
+      for (std::size_t i = 0; i < kSamplesPerProducer; ++i) {
+        const std::uint64_t start = nowNs();
+        pool.enqueue([]() {}).get();
+        samples.push_back(static_cast<double>(nowNs() - start));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  std::vector<double> merged;
+  for (const auto& samples : perProducer) {
+    merged.insert(merged.end(), samples.begin(), samples.end());
+  }
+  std::sort(merged.begin(), merged.end());
+  char buf[96];
+  std::snprintf(buf, sizeof(buf), "latency/workers=%zu/producers=%zu",
+                workers, producers);
+  emitRecord(buf, merged.size(), merged.front(),
+             merged[merged.size() / 2], merged[merged.size() * 99 / 100]);
+}
+
+}  // namespace
+
+int main() {
+  std::printf("[\n");
+  for (std::size_t workers : {1, 2, 4}) {
+    benchTaskThroughput(workers);
+    benchParallelFor(workers);
+  }
+  for (std::size_t workers : {1, 2, 4}) {
+    for (std::size_t producers : {1, 4}) {
+      benchLatencyUnderContention(workers, producers);
+    }
+  }
+  std::printf("\n]\n");
+  return 0;
+}
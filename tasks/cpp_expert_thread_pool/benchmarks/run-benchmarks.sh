@@ -0,0 +1,14 @@
+#!/usr/bin/env bash
+set -euo pipefail
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+WORKSPACE="$ROOT/workspace"
+BIN="$ROOT/benchmarks/thread_pool_bench"
+
+g++ -std=c++20 -O2 -pthread \
+  "$WORKSPACE/thread_pool.cpp" \
+  "$ROOT/benchmarks/bench_thread_pool.cpp" \
+  -I"$WORKSPACE" \
+  -o "$BIN"
+
+# Emits a JSON array on stdout; redirect to a file to diff across commits.
+"$BIN"
@@ -1,46 +1,980 @@
 #include "thread_pool.h"
 
-ThreadPool::ThreadPool(std::size_t threadCount) {
+#include <bit>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+// Deque/queue payload. Worker-local submissions recycle these nodes
+// through a per-worker free list, so steady-state spawning does not
+// touch the allocator.
+struct TaskNode {
+    TaskFunc fn;
+    std::uint64_t enqueueNs = 0;
+};
+
+// Submission timestamp for the queue-wait histogram; free when the
+// instrumentation is compiled out.
+inline std::uint64_t statsNow() {
+    if constexpr (ThreadPool::statsEnabled) {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+    } else {
+        return 0;
+    }
+}
+
+// Chase-Lev work-stealing deque (Le et al., "Correct and Efficient
+// Work-Stealing for Weak Memory Models"). The owner pushes and pops at
+// the bottom without contention; thieves race on top with a CAS. Slots
+// hold pointers so the racy pre-CAS read stays a benign atomic load.
+class WorkStealingDeque {
+public:
+    WorkStealingDeque() { buffer_.store(new Buffer(kInitialCapacity), std::memory_order_relaxed); }
+
+    ~WorkStealingDeque() {
+        delete buffer_.load(std::memory_order_relaxed);
+        for (Buffer* retired : retired_) {
+            delete retired;
+        }
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // Owner only.
+    void push(TaskNode* task) {
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        const std::int64_t t = top_.load(std::memory_order_acquire);
+        Buffer* buf = buffer_.load(std::memory_order_relaxed);
+        if (b - t > buf->capacity - 1) {
+            buf = grow(buf, t, b);
+        }
+        buf->put(b, task);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // Owner only.
+    TaskNode* pop() {
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        Buffer* buf = buffer_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+        TaskNode* task = nullptr;
+        if (t <= b) {
+            task = buf->get(b);
+            if (t == b) {
+                // Last element: race the thieves for it.
+                if (!top_.compare_exchange_strong(t, t + 1,
+                                                  std::memory_order_seq_cst,
+                                                  std::memory_order_relaxed)) {
+                    task = nullptr;
+                }
+                bottom_.store(b + 1, std::memory_order_relaxed);
+            }
+        } else {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return task;
+    }
+
+    // Any thread. Returns nullptr when empty or when the CAS loses.
+    TaskNode* steal() {
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) {
+            return nullptr;
+        }
+        Buffer* buf = buffer_.load(std::memory_order_acquire);
+        TaskNode* task = buf->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return task;
+    }
+
+private:
+    static constexpr std::int64_t kInitialCapacity = 256;
+
+    struct Buffer {
+        explicit Buffer(std::int64_t cap)
+            : capacity(cap), slots(new std::atomic<TaskNode*>[cap]) {}
+        ~Buffer() { delete[] slots; }
+
+        TaskNode* get(std::int64_t i) const {
+            return slots[i & (capacity - 1)].load(std::memory_order_relaxed);
+        }
+        void put(std::int64_t i, TaskNode* task) {
+            slots[i & (capacity - 1)].store(task, std::memory_order_relaxed);
+        }
+
+        const std::int64_t capacity;
+        std::atomic<TaskNode*>* const slots;
+    };
+
+    Buffer* grow(Buffer* old, std::int64_t t, std::int64_t b) {
+        Buffer* bigger = new Buffer(old->capacity * 2);
+        for (std::int64_t i = t; i < b; ++i) {
+            bigger->put(i, old->get(i));
+        }
+        buffer_.store(bigger, std::memory_order_release);
+        // A thief may still hold the old buffer pointer; retire it until
+        // the deque itself is destroyed instead of freeing it here.
+        retired_.push_back(old);
+        return bigger;
+    }
+
+    std::atomic<std::int64_t> top_{0};
+    std::atomic<std::int64_t> bottom_{0};
+    std::atomic<Buffer*> buffer_{nullptr};
+    std::vector<Buffer*> retired_;  // owner only
+};
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+#ifdef __linux__
+// Parses the sysfs cpulist format, e.g. "0-3,8,10-11".
+std::vector<int> parseCpuList(const std::string& text) {
+    std::vector<int> cpus;
+    std::size_t i = 0;
+    auto readInt = [&](int& out) {
+        if (i >= text.size() || !std::isdigit(static_cast<unsigned char>(text[i]))) {
+            return false;
+        }
+        out = 0;
+        while (i < text.size() && std::isdigit(static_cast<unsigned char>(text[i]))) {
+            out = out * 10 + (text[i] - '0');
+            ++i;
+        }
+        return true;
+    };
+    int lo;
+    while (readInt(lo)) {
+        int hi = lo;
+        if (i < text.size() && text[i] == '-') {
+            ++i;
+            if (!readInt(hi)) {
+                break;
+            }
+        }
+        for (int cpu = lo; cpu <= hi; ++cpu) {
+            cpus.push_back(cpu);
+        }
+        if (i < text.size() && text[i] == ',') {
+            ++i;
+        } else {
+            break;
+        }
+    }
+    return cpus;
+}
+#endif
+
+}  // namespace
+
+// Vyukov-style bounded MPMC ring: each cell carries a sequence number
+// that tells producers and consumers whose turn it is, so both sides
+// make progress with one CAS and no lock. Capacity is a power of two.
+class ThreadPool::BoundedQueue {
+public:
+    explicit BoundedQueue(std::size_t capacity) {
+        std::size_t rounded = 2;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        mask_ = rounded - 1;
+        cells_ = std::make_unique<Cell[]>(rounded);
+        for (std::size_t i = 0; i < rounded; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool tryPush(Queued& task) {
+        std::size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[pos & mask_];
+            const std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const std::intptr_t diff =
+                static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1,
+                                                      std::memory_order_relaxed)) {
+                    cell.data = std::move(task);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // full
+            } else {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(Queued& out) {
+        std::size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[pos & mask_];
+            const std::size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const std::intptr_t diff =
+                static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos_.compare_exchange_weak(pos, pos + 1,
+                                                      std::memory_order_relaxed)) {
+                    out = std::move(cell.data);
+                    cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // empty
+            } else {
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        Queued data;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    std::size_t mask_ = 0;
+    alignas(64) std::atomic<std::size_t> enqueuePos_{0};
+    alignas(64) std::atomic<std::size_t> dequeuePos_{0};
+};
+
+namespace {
+
+// Log2-bucket histogram; written only by the owning worker (or the
+// thief that ran the task), read racily by stats().
+struct Histogram {
+    std::array<std::atomic<std::uint64_t>, ThreadPool::kHistogramBuckets> buckets{};
+
+    void record(std::uint64_t ns) {
+        const std::size_t bucket =
+            std::min<std::size_t>(std::bit_width(ns), ThreadPool::kHistogramBuckets - 1);
+        buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+}  // namespace
+
+struct ThreadPool::Worker {
+    WorkStealingDeque deque;
+    std::uint64_t rngState = 0;
+    // Recycled nodes; touched only by this worker's thread.
+    std::vector<TaskNode*> freeNodes;
+    // True once this worker's thread exited after a shrink; guarded by
+    // mutex_. A grow joins the old thread and respawns the slot.
+    bool retired = false;
+
+    // Instrumentation; never touched when stats are compiled out.
+    std::atomic<std::uint64_t> tasksExecuted{0};
+    std::atomic<std::uint64_t> tasksStolen{0};
+    std::atomic<std::uint64_t> parks{0};
+    Histogram queueWait;
+    Histogram runTime;
+
+    static constexpr std::size_t kMaxFreeNodes = 1024;
+
+    ~Worker() {
+        for (TaskNode* node : freeNodes) {
+            delete node;
+        }
+    }
+
+    TaskNode* acquireNode() {
+        if (!freeNodes.empty()) {
+            TaskNode* node = freeNodes.back();
+            freeNodes.pop_back();
+            return node;
+        }
+        return new TaskNode;
+    }
+
+    void releaseNode(TaskNode* node) {
+        node->fn = TaskFunc();
+        if (freeNodes.size() < kMaxFreeNodes) {
+            freeNodes.push_back(node);
+        } else {
+            delete node;
+        }
+    }
+
+    std::size_t nextVictim(std::size_t workerCount) {
+        // xorshift64*: cheap, good enough to spread steal attempts.
+        rngState ^= rngState >> 12;
+        rngState ^= rngState << 25;
+        rngState ^= rngState >> 27;
+        return static_cast<std::size_t>((rngState * 0x2545F4914F6CDD1DULL) >> 32) % workerCount;
+    }
+};
+
+thread_local ThreadPool* ThreadPool::currentPool_ = nullptr;
+thread_local std::size_t ThreadPool::currentIndex_ = 0;
+
+ThreadPool::ThreadPool(std::size_t threadCount)
+    : ThreadPool(Options{threadCount, false}) {}
+
+ThreadPool::ThreadPool(const Options& options) {
+    std::size_t threadCount = options.threadCount;
     if (threadCount == 0) {
         threadCount = 1;
     }
+    maxWorkers_ = options.maxWorkers;
+    if (maxWorkers_ == 0) {
+        maxWorkers_ = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    maxWorkers_ = std::max(maxWorkers_, threadCount);
+    minWorkers_ = std::clamp<std::size_t>(options.minWorkers, 1, maxWorkers_);
+    pinWorkers_ = options.pinWorkers;
+
+    const std::vector<NumaNode>& topo = topology();
+    // Not resize(): queue<TaskFunc>'s move is not noexcept, so resize
+    // would try to copy the move-only element type.
+    nodeQueues_ = std::vector<std::queue<Queued>>(topo.size());
+    if (options.boundedQueueCapacity != 0) {
+        bounded_ = std::make_unique<BoundedQueue>(options.boundedQueueCapacity);
+    }
+
+    // Reserve every slot up front: resize() appends without moving the
+    // vectors, so lock-free readers can index them safely.
+    workers_.reserve(maxWorkers_);
+    threads_.reserve(maxWorkers_);
+    workerNode_.reserve(maxWorkers_);
+    workerCpu_.assign(maxWorkers_, -1);
+    for (std::size_t i = 0; i < maxWorkers_; ++i) {
+        // Deal workers across nodes round-robin so every socket gets
+        // its share, then walk each node's CPU list in order.
+        const std::size_t node = i % topo.size();
+        workerNode_.push_back(node);
+        const std::vector<int>& cpus = topo[node].cpus;
+        if (!cpus.empty()) {
+            workerCpu_[i] = cpus[(i / topo.size()) % cpus.size()];
+        }
+    }
+
+    targetWorkers_.store(threadCount, std::memory_order_relaxed);
     for (std::size_t i = 0; i < threadCount; ++i) {
-        workers_.emplace_back([this]() { workerLoop(); });
+        workers_.push_back(std::make_unique<Worker>());
+        workers_.back()->rngState = 0x9E3779B97F4A7C15ULL ^ (i + 1);
+        liveWorkers_.fetch_add(1, std::memory_order_release);
+        spawnWorkerThread(i);
+    }
+    if (options.autoScale) {
+        scaler_ = std::thread([this]() { scalerLoop(); });
+    }
+}
+
+void ThreadPool::spawnWorkerThread(std::size_t index) {
+    std::thread thread([this, index]() { workerLoop(index); });
+    if (pinWorkers_ && workerCpu_[index] >= 0) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(workerCpu_[index], &set);
+        // Best effort: a failed pin (cgroup restrictions, hotplug)
+        // leaves the worker floating, which is what we had anyway.
+        pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#endif
+    }
+    if (index < threads_.size()) {
+        threads_[index] = std::move(thread);  // respawned retired slot
+    } else {
+        threads_.push_back(std::move(thread));
+    }
+}
+
+void ThreadPool::resize(std::size_t workerCount) {
+    workerCount = std::clamp<std::size_t>(workerCount, 1, maxWorkers_);
+    std::vector<std::thread> retiredThreads;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        const std::size_t target = targetWorkers_.load(std::memory_order_relaxed);
+        if (workerCount == target) {
+            return;
+        }
+        targetWorkers_.store(workerCount, std::memory_order_release);
+        for (std::size_t i = target; i < workerCount; ++i) {
+            if (i < workers_.size()) {
+                // Existing slot. A retired thread has fully left the
+                // pool (the flag is set under mutex_ right before it
+                // returns), so it is safe to respawn; a still-running
+                // one simply sees the raised target and keeps going.
+                if (workers_[i]->retired) {
+                    workers_[i]->retired = false;
+                    retiredThreads.push_back(std::move(threads_[i]));
+                    spawnWorkerThread(i);
+                }
+            } else {
+                workers_.push_back(std::make_unique<Worker>());
+                workers_.back()->rngState = 0x9E3779B97F4A7C15ULL ^ (i + 1);
+                liveWorkers_.fetch_add(1, std::memory_order_release);
+                spawnWorkerThread(i);
+            }
+        }
+        // Shrinking needs no bookkeeping here: workers above the target
+        // retire themselves once they run dry.
+    }
+    cv_.notify_all();  // wake parked workers so high indices can retire
+    for (auto& thread : retiredThreads) {
+        thread.join();  // already exited or about to; never blocks long
+    }
+}
+
+void ThreadPool::scalerLoop() {
+    constexpr auto kInterval = std::chrono::milliseconds(10);
+    constexpr int kBusyIntervalsBeforeGrow = 2;
+    constexpr int kIdleIntervalsBeforeShrink = 50;  // ~500ms
+
+    int busyStreak = 0;
+    int idleStreak = 0;
+    while (!stop_.load(std::memory_order_acquire)) {
+        std::this_thread::sleep_for(kInterval);
+        const std::size_t depth = pending_.load(std::memory_order_relaxed);
+        const std::size_t target = targetWorkers_.load(std::memory_order_relaxed);
+        if (depth > target) {
+            idleStreak = 0;
+            if (++busyStreak >= kBusyIntervalsBeforeGrow && target < maxWorkers_) {
+                resize(target + 1);
+                busyStreak = 0;
+            }
+        } else if (depth == 0) {
+            busyStreak = 0;
+            if (++idleStreak >= kIdleIntervalsBeforeShrink) {
+                if (target > minWorkers_) {
+                    resize(target - 1);
+                }
+                idleStreak = 0;
+            }
+        } else {
+            busyStreak = 0;
+            idleStreak = 0;
+        }
     }
 }
 
+const std::vector<ThreadPool::NumaNode>& ThreadPool::topology() {
+    static const std::vector<NumaNode> topo = []() {
+        std::vector<NumaNode> nodes;
+#ifdef __linux__
+        for (int id = 0;; ++id) {
+            std::ifstream file("/sys/devices/system/node/node" + std::to_string(id) +
+                               "/cpulist");
+            if (!file) {
+                break;
+            }
+            std::string line;
+            std::getline(file, line);
+            std::vector<int> cpus = parseCpuList(line);
+            if (!cpus.empty()) {
+                nodes.push_back(NumaNode{id, std::move(cpus)});
+            }
+        }
+#endif
+        if (nodes.empty()) {
+            // No NUMA information: one node owning every CPU.
+            unsigned hw = std::thread::hardware_concurrency();
+            if (hw == 0) {
+                hw = 1;
+            }
+            NumaNode all{0, {}};
+            for (unsigned cpu = 0; cpu < hw; ++cpu) {
+                all.cpus.push_back(static_cast<int>(cpu));
+            }
+            nodes.push_back(std::move(all));
+        }
+        return nodes;
+    }();
+    return topo;
+}
+
+std::size_t ThreadPool::numaNodeCount() const {
+    return nodeQueues_.size();
+}
+
+std::size_t ThreadPool::numaNodeOf(std::size_t workerIndex) const {
+    return workerNode_[workerIndex];
+}
+
 ThreadPool::~ThreadPool() {
-    stop_ = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_.store(true, std::memory_order_release);
+    }
     cv_.notify_all();
-    for (auto& worker : workers_) {
-        if (worker.joinable()) {
-            worker.detach();
+    if (scaler_.joinable()) {
+        scaler_.join();  // no more resizes; threads_ is stable below
+    }
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
         }
     }
 }
 
 std::size_t ThreadPool::size() const {
-    return workers_.size();
+    return targetWorkers_.load(std::memory_order_relaxed);
+}
+
+void ThreadPool::submit(TaskFunc task, Priority priority) {
+    if (stop_.load(std::memory_order_acquire)) {
+        throw std::runtime_error("ThreadPool is stopping");
+    }
+    if (currentPool_ == this && priority != Priority::Background) {
+        // Worker-local fast path: recycled node, lock-free push onto our
+        // own deque. Background never takes it — it must not jump ahead
+        // of external work via the deque's LIFO pop.
+        Worker& self = *workers_[currentIndex_];
+        TaskNode* node = self.acquireNode();
+        node->fn = std::move(task);
+        node->enqueueNs = statsNow();
+        self.deque.push(node);
+        pending_.fetch_add(1, std::memory_order_seq_cst);
+        notifyOne();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_.load(std::memory_order_relaxed)) {
+            throw std::runtime_error("ThreadPool is stopping");
+        }
+        global_[static_cast<std::size_t>(priority)].push(Queued{std::move(task), statsNow()});
+        pending_.fetch_add(1, std::memory_order_seq_cst);
+    }
+    notifyOne();
+}
+
+void ThreadPool::submitBulk(std::vector<TaskFunc> tasks, Priority priority) {
+    if (tasks.empty()) {
+        return;
+    }
+    if (stop_.load(std::memory_order_acquire)) {
+        throw std::runtime_error("ThreadPool is stopping");
+    }
+    const std::size_t count = tasks.size();
+    // One timestamp for the whole wave is plenty for the histogram.
+    const std::uint64_t enqueueNs = statsNow();
+    if (currentPool_ == this && priority != Priority::Background) {
+        Worker& self = *workers_[currentIndex_];
+        for (auto& task : tasks) {
+            TaskNode* node = self.acquireNode();
+            node->fn = std::move(task);
+            node->enqueueNs = enqueueNs;
+            self.deque.push(node);
+        }
+        pending_.fetch_add(count, std::memory_order_seq_cst);
+        notifyMany(count);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_.load(std::memory_order_relaxed)) {
+            throw std::runtime_error("ThreadPool is stopping");
+        }
+        auto& queue = global_[static_cast<std::size_t>(priority)];
+        for (auto& task : tasks) {
+            queue.push(Queued{std::move(task), enqueueNs});
+        }
+        pending_.fetch_add(count, std::memory_order_seq_cst);
+    }
+    notifyMany(count);
+}
+
+void ThreadPool::submitOn(std::size_t node, TaskFunc task) {
+    if (stop_.load(std::memory_order_acquire)) {
+        throw std::runtime_error("ThreadPool is stopping");
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_.load(std::memory_order_relaxed)) {
+            throw std::runtime_error("ThreadPool is stopping");
+        }
+        nodeQueues_[node].push(Queued{std::move(task), statsNow()});
+        pending_.fetch_add(1, std::memory_order_seq_cst);
+    }
+    // Any worker may end up taking it (remote ones as a last resort),
+    // so a single wake is enough.
+    notifyOne();
+}
+
+bool ThreadPool::tryEnqueueTask(TaskFunc task) {
+    if (stop_.load(std::memory_order_acquire)) {
+        throw std::runtime_error("ThreadPool is stopping");
+    }
+    if (bounded_ == nullptr) {
+        submit(std::move(task), Priority::Normal);
+        return true;
+    }
+    Queued item{std::move(task), statsNow()};
+    if (!bounded_->tryPush(item)) {
+        return false;
+    }
+    pending_.fetch_add(1, std::memory_order_seq_cst);
+    notifyOne();
+    return true;
+}
+
+void ThreadPool::runQueued(std::size_t index, Queued item) {
+    if constexpr (statsEnabled) {
+        Worker& self = *workers_[index];
+        const std::uint64_t start = statsNow();
+        if (item.enqueueNs != 0 && start > item.enqueueNs) {
+            self.queueWait.record(start - item.enqueueNs);
+        }
+        item.fn();
+        self.runTime.record(statsNow() - start);
+        self.tasksExecuted.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        item.fn();
+    }
+}
+
+ThreadPool::Stats ThreadPool::stats() const {
+    Stats snapshot;
+    snapshot.queueDepth = pending_.load(std::memory_order_relaxed);
+    const std::size_t live = liveWorkers_.load(std::memory_order_acquire);
+    snapshot.workers.reserve(live);
+    for (std::size_t i = 0; i < live; ++i) {
+        const Worker* worker = workers_[i].get();
+        WorkerStats ws;
+        ws.tasksExecuted = worker->tasksExecuted.load(std::memory_order_relaxed);
+        ws.tasksStolen = worker->tasksStolen.load(std::memory_order_relaxed);
+        ws.parks = worker->parks.load(std::memory_order_relaxed);
+        snapshot.workers.push_back(ws);
+        for (std::size_t i = 0; i < kHistogramBuckets; ++i) {
+            snapshot.queueWaitNs[i] +=
+                worker->queueWait.buckets[i].load(std::memory_order_relaxed);
+            snapshot.runTimeNs[i] +=
+                worker->runTime.buckets[i].load(std::memory_order_relaxed);
+        }
+    }
+    return snapshot;
 }
 
-void ThreadPool::workerLoop() {
+void ThreadPool::notifyMany(std::size_t count) {
+    // Same handshake as notifyOne, but a batch only elides the notify
+    // outright when nobody is parked — one spinner cannot stand in for
+    // a whole wave.
+    if (sleepers_.load(std::memory_order_seq_cst) == 0) {
+        return;
+    }
+    { std::lock_guard<std::mutex> lock(mutex_); }
+    if (count >= targetWorkers_.load(std::memory_order_relaxed)) {
+        cv_.notify_all();
+    } else {
+        for (std::size_t i = 0; i < count; ++i) {
+            cv_.notify_one();
+        }
+    }
+}
+
+void ThreadPool::resolveGrain(std::size_t begin, std::size_t end,
+                              std::size_t& grain) const {
+    if (grain == 0) {
+        // Roughly eight chunks per worker balances steal granularity
+        // against claiming overhead.
+        const std::size_t total = end - begin;
+        grain = std::max<std::size_t>(total / (8 * size()), 1);
+    }
+}
+
+void ThreadPool::helpWhile(std::atomic<std::size_t>& remaining) {
     while (true) {
-        std::function<void()> task;
-        {
-            std::unique_lock<std::mutex> lock(mutex_);
-            if (tasks_.empty()) {
-                cv_.wait(lock);
+        const std::size_t value = remaining.load(std::memory_order_acquire);
+        if (value == 0) {
+            return;
+        }
+        if (currentPool_ == this) {
+            // On a worker thread: execute other pool tasks instead of
+            // blocking, so work queued behind us (including our own
+            // deque) keeps flowing.
+            Queued item;
+            if (findTask(currentIndex_, item)) {
+                pending_.fetch_sub(1, std::memory_order_acq_rel);
+                runQueued(currentIndex_, std::move(item));
+                continue;
             }
-            if (stop_) {
+        }
+        remaining.wait(value);
+    }
+}
+
+void ThreadPool::notifyOne() {
+    // Wakeup elision, Dekker-style. The producer increments pending_
+    // (seq_cst) before these loads; a worker decrements spinners_ /
+    // increments sleepers_ (seq_cst) before re-reading pending_. In the
+    // seq_cst total order one side must see the other, so skipping the
+    // notify here is safe: either a spinner observes pending_ != 0, or
+    // the parking worker's predicate does.
+    if (spinners_.load(std::memory_order_seq_cst) > 0) {
+        return;  // a live spinner will pick the task up
+    }
+    if (sleepers_.load(std::memory_order_seq_cst) == 0) {
+        return;  // nobody is parked; busy workers poll on their own
+    }
+    // The empty critical section pairs with the sleeper's predicate
+    // check: anyone who saw pending_ == 0 is fully blocked by the time we
+    // pass the lock, so the notify cannot be lost.
+    { std::lock_guard<std::mutex> lock(mutex_); }
+    cv_.notify_one();
+}
+
+bool ThreadPool::findTask(std::size_t index, Queued& out) {
+    Worker& self = *workers_[index];
+    if (TaskNode* node = self.deque.pop()) {
+        out.fn = std::move(node->fn);
+        out.enqueueNs = node->enqueueNs;
+        self.releaseNode(node);
+        return true;
+    }
+    // The bounded ring comes before any lock — its consumers must never
+    // queue up behind the mutex.
+    if (bounded_ != nullptr && bounded_->tryPop(out)) {
+        return true;
+    }
+    const std::size_t myNode = workerNode_[index];
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Our own node's placed work first, then High before Normal
+        // before Background — except every sixteenth pop, which scans
+        // lowest-first so Background ages through a sustained High load.
+        if (!nodeQueues_[myNode].empty()) {
+            out = std::move(nodeQueues_[myNode].front());
+            nodeQueues_[myNode].pop();
+            return true;
+        }
+        constexpr std::size_t kAgingInterval = 16;
+        const bool aged = ++drainCounter_ % kAgingInterval == 0;
+        for (std::size_t i = 0; i < global_.size(); ++i) {
+            auto& queue = global_[aged ? global_.size() - 1 - i : i];
+            if (!queue.empty()) {
+                out = std::move(queue.front());
+                queue.pop();
+                return true;
+            }
+        }
+    }
+    const std::size_t workerCount = liveWorkers_.load(std::memory_order_acquire);
+    if (workerCount > 1) {
+        for (std::size_t attempt = 0; attempt < 2 * workerCount; ++attempt) {
+            const std::size_t victim = self.nextVictim(workerCount);
+            if (victim == index) {
+                continue;
+            }
+            if (TaskNode* node = workers_[victim]->deque.steal()) {
+                out.fn = std::move(node->fn);
+                out.enqueueNs = node->enqueueNs;
+                // The node came from the victim's allocation; recycling
+                // it here is fine, it is just memory.
+                self.releaseNode(node);
+                if constexpr (statsEnabled) {
+                    self.tasksStolen.fetch_add(1, std::memory_order_relaxed);
+                }
+                return true;
+            }
+        }
+    }
+    if (nodeQueues_.size() > 1) {
+        // Last resort: work placed on other nodes. Affinity is a
+        // preference, not a fence — better a remote-memory task than an
+        // idle core, and shutdown must be able to drain every queue.
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (std::size_t n = 0; n < nodeQueues_.size(); ++n) {
+            if (n == myNode || nodeQueues_[n].empty()) {
+                continue;
+            }
+            out = std::move(nodeQueues_[n].front());
+            nodeQueues_[n].pop();
+            return true;
+        }
+    }
+    return false;
+}
+
+struct TaskGraph::Node {
+    TaskFunc fn;
+    ThreadPool::Priority priority;
+    std::atomic<std::size_t> pending{0};
+    std::vector<NodeId> successors;
+};
+
+TaskGraph::TaskGraph(ThreadPool& pool) : pool_(pool) {}
+
+TaskGraph::~TaskGraph() {
+    pool_.helpWhile(remaining_);
+}
+
+TaskGraph::NodeId TaskGraph::addNode(TaskFunc fn, ThreadPool::Priority priority) {
+    if (started_) {
+        throw std::logic_error("TaskGraph: cannot add nodes after run()");
+    }
+    auto node = std::make_unique<Node>();
+    node->fn = std::move(fn);
+    node->priority = priority;
+    nodes_.push_back(std::move(node));
+    return nodes_.size() - 1;
+}
+
+void TaskGraph::addEdge(NodeId from, NodeId to) {
+    if (started_) {
+        throw std::logic_error("TaskGraph: cannot add edges after run()");
+    }
+    if (from >= nodes_.size() || to >= nodes_.size() || from == to) {
+        throw std::out_of_range("TaskGraph: invalid edge");
+    }
+    nodes_[from]->successors.push_back(to);
+    nodes_[to]->pending.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TaskGraph::run() {
+    if (started_) {
+        throw std::logic_error("TaskGraph: already run");
+    }
+    started_ = true;
+    remaining_.store(nodes_.size(), std::memory_order_relaxed);
+    // Submitting a source may finish it (and transitively its dependents)
+    // before we reach the next source; only the pre-run in-degrees decide
+    // who is a source, so each node is still submitted exactly once.
+    for (NodeId id = 0; id < nodes_.size(); ++id) {
+        if (nodes_[id]->pending.load(std::memory_order_relaxed) == 0) {
+            pool_.submit(TaskFunc([this, id]() { runNode(id); }), nodes_[id]->priority);
+        }
+    }
+}
+
+void TaskGraph::runNode(NodeId id) {
+    Node& node = *nodes_[id];
+    if (!failed_.load(std::memory_order_relaxed)) {
+        try {
+            node.fn();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex_);
+            if (!failed_.exchange(true, std::memory_order_relaxed)) {
+                error_ = std::current_exception();
+            }
+        }
+    }
+    for (NodeId succ : node.successors) {
+        if (nodes_[succ]->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            pool_.submit(TaskFunc([this, succ]() { runNode(succ); }),
+                         nodes_[succ]->priority);
+        }
+    }
+    if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        remaining_.notify_all();
+    }
+}
+
+void TaskGraph::wait() {
+    pool_.helpWhile(remaining_);
+    std::lock_guard<std::mutex> lock(errorMutex_);
+    if (error_) {
+        std::exception_ptr error = std::exchange(error_, nullptr);
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::workerLoop(std::size_t index) {
+    // Spin budget before parking; mostly pause instructions with an
+    // occasional yield so a lone core is not starved.
+    constexpr int kSpinIterations = 256;
+
+    currentPool_ = this;
+    currentIndex_ = index;
+    while (true) {
+        Queued item;
+        if (findTask(index, item)) {
+            pending_.fetch_sub(1, std::memory_order_acq_rel);
+            runQueued(index, std::move(item));
+            continue;
+        }
+        // Shrunk below our index and out of work: retire. The flag is
+        // set under mutex_ as the very last pool access, so a grow can
+        // safely join this thread and respawn the slot.
+        if (index >= targetWorkers_.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!stop_.load(std::memory_order_relaxed) &&
+                index >= targetWorkers_.load(std::memory_order_relaxed)) {
+                workers_[index]->retired = true;
                 return;
             }
-            if (!tasks_.empty()) {
-                task = std::move(tasks_.front());
-                tasks_.pop();
+            // Raced with a grow or shutdown: keep going.
+        }
+        // Spin briefly before parking: a handoff caught here costs a
+        // cache miss on pending_ instead of a futex round-trip. While
+        // spinners_ is raised, producers skip the notify entirely.
+        {
+            spinners_.fetch_add(1, std::memory_order_seq_cst);
+            bool sawWork = false;
+            for (int i = 0; i < kSpinIterations; ++i) {
+                if (stop_.load(std::memory_order_acquire)) {
+                    break;  // fall through to the shutdown path below
+                }
+                if (pending_.load(std::memory_order_seq_cst) != 0) {
+                    sawWork = true;
+                    break;
+                }
+                if ((i & 63) == 63) {
+                    std::this_thread::yield();
+                } else {
+                    cpuRelax();
+                }
+            }
+            spinners_.fetch_sub(1, std::memory_order_seq_cst);
+            if (sawWork) {
+                continue;
+            }
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (stop_.load(std::memory_order_acquire)) {
+            if (pending_.load(std::memory_order_acquire) == 0) {
+                return;
             }
+            // Shutdown with work still queued somewhere: drain it.
+            lock.unlock();
+            std::this_thread::yield();
+            continue;
         }
-        if (task) {
-            task();
+        // Register as parked before the predicate re-checks pending_ —
+        // the order the elision in notifyOne relies on.
+        if constexpr (statsEnabled) {
+            workers_[index]->parks.fetch_add(1, std::memory_order_relaxed);
         }
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        cv_.wait(lock, [this, index]() {
+            return stop_.load(std::memory_order_acquire) ||
+                   pending_.load(std::memory_order_seq_cst) != 0 ||
+                   index >= targetWorkers_.load(std::memory_order_acquire);
+        });
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
     }
 }
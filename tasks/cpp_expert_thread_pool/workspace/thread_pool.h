@@ -1,46 +1,949 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <condition_variable>
+#include <coroutine>
 #include <cstddef>
-#include <functional>
+#include <cstdint>
 #include <future>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
 #include <mutex>
+#include <new>
+#include <optional>
 #include <queue>
 #include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+// Pool instrumentation is on by default; build with -DTHREAD_POOL_STATS=0
+// to strip every timestamp and counter update from the hot paths.
+#ifndef THREAD_POOL_STATS
+#define THREAD_POOL_STATS 1
+#endif
+
+// Move-only nullary callable with 64 bytes of inline storage. Callables
+// that fit (and are nothrow-movable, so moves stay noexcept) are stored
+// in place — no heap allocation, unlike std::function's copyable
+// type-erasure; larger ones fall back to a single heap cell. One-shot:
+// invoke at most once.
+class TaskFunc {
+public:
+    static constexpr std::size_t kInlineSize = 64;
+
+    TaskFunc() noexcept = default;
+
+    template <class Fn,
+              class = std::enable_if_t<!std::is_same_v<std::decay_t<Fn>, TaskFunc>>>
+    TaskFunc(Fn&& fn) {
+        using F = std::decay_t<Fn>;
+        if constexpr (sizeof(F) <= kInlineSize &&
+                      alignof(F) <= alignof(std::max_align_t) &&
+                      std::is_nothrow_move_constructible_v<F>) {
+            ::new (static_cast<void*>(storage_)) F(std::forward<Fn>(fn));
+            vtable_ = &InlineOps<F>::vtable;
+        } else {
+            ::new (static_cast<void*>(storage_)) F*(new F(std::forward<Fn>(fn)));
+            vtable_ = &HeapOps<F>::vtable;
+        }
+    }
+
+    TaskFunc(TaskFunc&& other) noexcept : vtable_(other.vtable_) {
+        if (vtable_ != nullptr) {
+            vtable_->relocate(other.storage_, storage_);
+            other.vtable_ = nullptr;
+        }
+    }
+
+    TaskFunc& operator=(TaskFunc&& other) noexcept {
+        if (this != &other) {
+            reset();
+            vtable_ = other.vtable_;
+            if (vtable_ != nullptr) {
+                vtable_->relocate(other.storage_, storage_);
+                other.vtable_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    TaskFunc(const TaskFunc&) = delete;
+    TaskFunc& operator=(const TaskFunc&) = delete;
+
+    ~TaskFunc() { reset(); }
+
+    void operator()() { vtable_->invoke(storage_); }
+
+    explicit operator bool() const noexcept { return vtable_ != nullptr; }
+
+private:
+    struct VTable {
+        void (*invoke)(unsigned char*);
+        // Move-construct into `to` and destroy `from`.
+        void (*relocate)(unsigned char* from, unsigned char* to);
+        void (*destroy)(unsigned char*);
+    };
+
+    template <class F>
+    struct InlineOps {
+        static F* self(unsigned char* s) {
+            return std::launder(reinterpret_cast<F*>(s));
+        }
+        static void invoke(unsigned char* s) { (*self(s))(); }
+        static void relocate(unsigned char* from, unsigned char* to) {
+            F* f = self(from);
+            ::new (static_cast<void*>(to)) F(std::move(*f));
+            f->~F();
+        }
+        static void destroy(unsigned char* s) { self(s)->~F(); }
+        static constexpr VTable vtable{&invoke, &relocate, &destroy};
+    };
+
+    template <class F>
+    struct HeapOps {
+        static F* self(unsigned char* s) {
+            return *std::launder(reinterpret_cast<F**>(s));
+        }
+        static void invoke(unsigned char* s) { (*self(s))(); }
+        static void relocate(unsigned char* from, unsigned char* to) {
+            ::new (static_cast<void*>(to)) F*(self(from));
+        }
+        static void destroy(unsigned char* s) { delete self(s); }
+        static constexpr VTable vtable{&invoke, &relocate, &destroy};
+    };
+
+    void reset() noexcept {
+        if (vtable_ != nullptr) {
+            vtable_->destroy(storage_);
+            vtable_ = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+    const VTable* vtable_ = nullptr;
+};
+
+// Work-stealing thread pool. Each worker owns a Chase-Lev deque: tasks
+// submitted from inside a worker go to its own deque (LIFO pop for
+// locality), idle workers steal from random victims (FIFO steal), and
+// external callers go through a single locked global queue that workers
+// drain alongside their deques. The destructor blocks until all queued
+// work has run and every worker has joined.
 class ThreadPool {
 public:
+    // Scheduling class for externally submitted work. Workers drain High
+    // before Normal before Background, with an aging escape hatch: every
+    // sixteenth global pop scans lowest-first, so Background still makes
+    // progress under a sustained High load. Worker-local High/Normal
+    // submissions take the deque fast path as before; Background tasks
+    // always go through the global queues so spawned bulk work cannot
+    // jump ahead of external latency-sensitive tasks.
+    enum class Priority { High, Normal, Background };
+
+    // One NUMA node as reported by sysfs: its id and the CPUs it owns.
+    // On machines without NUMA information (or non-Linux builds) the
+    // topology degrades to a single node holding every CPU.
+    struct NumaNode {
+        int id;
+        std::vector<int> cpus;
+    };
+
+    struct Options {
+        std::size_t threadCount = std::thread::hardware_concurrency();
+        // Pin each worker to one CPU, spreading workers across NUMA
+        // nodes round-robin so every socket gets its share. Pinning
+        // failures are ignored — the pool still runs, just unpinned.
+        bool pinWorkers = false;
+        // Non-zero enables a fixed-capacity lock-free MPMC ring
+        // (Vyukov-style, capacity rounded up to a power of two) that
+        // tryEnqueue() feeds and workers drain without the mutex.
+        // Bounded by design: when the ring is full, tryEnqueue() fails
+        // so the producer can shed load instead of growing a queue.
+        std::size_t boundedQueueCapacity = 0;
+        // Autoscaling: a background thread grows the pool by one worker
+        // while the queue stays deeper than the worker count and
+        // retires one after a sustained idle period, within
+        // [minWorkers, maxWorkers]. maxWorkers == 0 means
+        // max(threadCount, hardware_concurrency()); it also caps
+        // resize() on pools without autoscaling.
+        bool autoScale = false;
+        std::size_t minWorkers = 1;
+        std::size_t maxWorkers = 0;
+    };
+
     explicit ThreadPool(std::size_t threadCount = std::thread::hardware_concurrency());
+    explicit ThreadPool(const Options& options);
     ~ThreadPool();
 
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // The callable, its arguments and the promise all live in the task's
+    // inline buffer when they fit, so a typical lambda submission costs
+    // only the future's shared state — no packaged_task, bind or
+    // std::function allocations.
     template <class Fn, class... Args>
     auto enqueue(Fn&& fn, Args&&... args) -> std::future<std::invoke_result_t<Fn, Args...>> {
         using ReturnT = std::invoke_result_t<Fn, Args...>;
 
-        auto task = std::make_shared<std::packaged_task<ReturnT()>>(
-            std::bind(std::forward<Fn>(fn), std::forward<Args>(args)...)
-        );
+        std::promise<ReturnT> promise;
+        std::future<ReturnT> future = promise.get_future();
+        submit(makeTask<ReturnT>(std::move(promise), std::forward<Fn>(fn),
+                                 std::forward<Args>(args)...),
+               Priority::Normal);
+        return future;
+    }
+
+    template <class Fn, class... Args>
+    auto enqueue(Priority priority, Fn&& fn, Args&&... args)
+        -> std::future<std::invoke_result_t<Fn, Args...>> {
+        using ReturnT = std::invoke_result_t<Fn, Args...>;
+
+        std::promise<ReturnT> promise;
+        std::future<ReturnT> future = promise.get_future();
+        submit(makeTask<ReturnT>(std::move(promise), std::forward<Fn>(fn),
+                                 std::forward<Args>(args)...),
+               priority);
+        return future;
+    }
+
+    // Batch submission: one lock acquisition and one counted notify for
+    // the whole wave instead of a mutex/notify round-trip per task. The
+    // range's elements are nullary callables; they are moved out when
+    // the range itself is passed as an rvalue (move-only callables work
+    // via enqueueBulk(std::move(vec))) and copied otherwise.
+    template <class Range>
+    auto enqueueBulk(Range&& range, Priority priority = Priority::Normal) {
+        using Fn = std::decay_t<decltype(*std::begin(range))>;
+        using ReturnT = std::invoke_result_t<Fn>;
+
+        std::vector<std::future<ReturnT>> futures;
+        std::vector<TaskFunc> batch;
+        consumeRange(std::forward<Range>(range), [&](auto&& fn) {
+            std::promise<ReturnT> promise;
+            futures.push_back(promise.get_future());
+            batch.push_back(makeTask<ReturnT>(std::move(promise),
+                                              std::forward<decltype(fn)>(fn)));
+        });
+        submitBulk(std::move(batch), priority);
+        return futures;
+    }
+
+    // Fire-and-forget variant: no futures and no promise state, so a
+    // wave of plain lambdas submits allocation-free plus a single
+    // lock/notify for the batch. Same move-out-of-rvalue-range rule as
+    // enqueueBulk.
+    template <class Range>
+    void enqueueBulkDetached(Range&& range, Priority priority = Priority::Normal) {
+        std::vector<TaskFunc> batch;
+        consumeRange(std::forward<Range>(range), [&](auto&& fn) {
+            batch.emplace_back(std::forward<decltype(fn)>(fn));
+        });
+        submitBulk(std::move(batch), priority);
+    }
 
-        {
-            std::unique_lock<std::mutex> lock(mutex_);
-            if (stop_) {
-                throw std::runtime_error("ThreadPool is stopping");
+    // Runs body(i) for every i in [begin, end). The range is split into
+    // grain-sized chunks that at most size() strip-mining tasks claim
+    // from a shared cursor, so cost is one shared state allocation and
+    // one task per worker — no per-chunk futures. The caller claims
+    // chunks too and, once the cursor drains, helps execute other pool
+    // tasks instead of sleeping, so nested calls from inside a worker
+    // cannot deadlock. body must be safe to invoke concurrently.
+    // grain == 0 picks roughly eight chunks per worker. The first
+    // exception out of body is rethrown to the caller after the join.
+    template <class Body>
+    void parallel_for(std::size_t begin, std::size_t end, std::size_t grain, Body body) {
+        if (begin >= end) {
+            return;
+        }
+        resolveGrain(begin, end, grain);
+        const std::size_t chunks = (end - begin + grain - 1) / grain;
+
+        struct State {
+            Body body;
+            std::size_t begin, end, grain, chunks;
+            std::atomic<std::size_t> cursor{0};
+            std::atomic<std::size_t> remaining;
+            std::atomic<bool> failed{false};
+            std::mutex errorMutex;
+            std::exception_ptr error;
+
+            explicit State(Body b) : body(std::move(b)) {}
+
+            void run() {
+                std::size_t chunk;
+                while ((chunk = cursor.fetch_add(1, std::memory_order_relaxed)) < chunks) {
+                    if (!failed.load(std::memory_order_relaxed)) {
+                        const std::size_t lo = begin + chunk * grain;
+                        const std::size_t hi = std::min(end, lo + grain);
+                        try {
+                            for (std::size_t i = lo; i < hi; ++i) {
+                                body(i);
+                            }
+                        } catch (...) {
+                            std::lock_guard<std::mutex> lock(errorMutex);
+                            if (!failed.exchange(true, std::memory_order_relaxed)) {
+                                error = std::current_exception();
+                            }
+                        }
+                    }
+                    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        remaining.notify_all();
+                    }
+                }
             }
-            tasks_.emplace([task]() { (*task)(); });
+        };
+
+        auto state = std::make_shared<State>(std::move(body));
+        state->begin = begin;
+        state->end = end;
+        state->grain = grain;
+        state->chunks = chunks;
+        state->remaining.store(chunks, std::memory_order_relaxed);
+
+        spawnStripTasks(chunks, [state]() { state->run(); });
+        state->run();
+        helpWhile(state->remaining);
+        if (state->failed.load(std::memory_order_acquire)) {
+            std::rethrow_exception(state->error);
         }
-        cv_.notify_one();
-        return task->get_future();
     }
 
+    // Reduction over [begin, end): body(i) produces a value, combine
+    // folds two values, identity seeds each participant's local
+    // accumulator. Same chunk-claiming scheme as parallel_for; each
+    // participant folds its chunks locally and merges once at the end,
+    // so combine runs O(workers) times, not O(n).
+    template <class T, class BodyFn, class CombineFn>
+    T parallel_reduce(std::size_t begin, std::size_t end, T identity,
+                      BodyFn body, CombineFn combine) {
+        if (begin >= end) {
+            return identity;
+        }
+        std::size_t grain = 0;
+        resolveGrain(begin, end, grain);
+        const std::size_t chunks = (end - begin + grain - 1) / grain;
+
+        struct State {
+            BodyFn body;
+            CombineFn combine;
+            T result;
+            std::size_t begin, end, grain, chunks;
+            std::atomic<std::size_t> cursor{0};
+            std::atomic<std::size_t> remaining;
+            std::atomic<bool> failed{false};
+            std::mutex mergeMutex;
+            std::exception_ptr error;
+
+            State(BodyFn b, CombineFn c, T id)
+                : body(std::move(b)), combine(std::move(c)), result(std::move(id)) {}
+
+            void run(const T& identity) {
+                T local = identity;
+                bool touched = false;
+                std::size_t claimed = 0;
+                std::size_t chunk;
+                while ((chunk = cursor.fetch_add(1, std::memory_order_relaxed)) < chunks) {
+                    ++claimed;
+                    if (!failed.load(std::memory_order_relaxed)) {
+                        const std::size_t lo = begin + chunk * grain;
+                        const std::size_t hi = std::min(end, lo + grain);
+                        try {
+                            for (std::size_t i = lo; i < hi; ++i) {
+                                local = combine(std::move(local), body(i));
+                                touched = true;
+                            }
+                        } catch (...) {
+                            std::lock_guard<std::mutex> lock(mergeMutex);
+                            if (!failed.exchange(true, std::memory_order_relaxed)) {
+                                error = std::current_exception();
+                            }
+                        }
+                    }
+                }
+                if (claimed == 0) {
+                    return;
+                }
+                if (touched) {
+                    std::lock_guard<std::mutex> lock(mergeMutex);
+                    result = combine(std::move(result), std::move(local));
+                }
+                // remaining is released in one batch AFTER the merge so the
+                // caller cannot observe zero until every participant's
+                // contribution is in result; decrementing per chunk inside
+                // the claim loop would let the join complete while a helper
+                // is still merging.
+                if (remaining.fetch_sub(claimed, std::memory_order_acq_rel) == claimed) {
+                    remaining.notify_all();
+                }
+            }
+        };
+
+        auto state = std::make_shared<State>(std::move(body), std::move(combine), identity);
+        state->begin = begin;
+        state->end = end;
+        state->grain = grain;
+        state->chunks = chunks;
+        state->remaining.store(chunks, std::memory_order_relaxed);
+
+        spawnStripTasks(chunks, [state, identity]() { state->run(identity); });
+        state->run(identity);
+        helpWhile(state->remaining);
+        if (state->failed.load(std::memory_order_acquire)) {
+            std::rethrow_exception(state->error);
+        }
+        return std::move(state->result);
+    }
+
+    // Current target worker count; lock-free.
     std::size_t size() const;
 
+    // Grows or shrinks the pool to workerCount threads, clamped to
+    // [1, maxWorkers]. Growing respawns retired slots or adds fresh
+    // workers; shrinking is cooperative — workers above the target
+    // retire once they run dry, so in-flight tasks always finish.
+    // Queued work is never dropped: whatever remains is drained by the
+    // surviving workers. No-op once shutdown has started.
+    void resize(std::size_t workerCount);
+
+    // Whether the instrumentation below actually records anything; with
+    // THREAD_POOL_STATS=0, stats() still exists but returns zeros and
+    // the hot paths carry no timestamps or counter updates.
+    static constexpr bool statsEnabled = THREAD_POOL_STATS != 0;
+    static constexpr std::size_t kHistogramBuckets = 64;
+
+    struct WorkerStats {
+        std::uint64_t tasksExecuted = 0;
+        std::uint64_t tasksStolen = 0;
+        std::uint64_t parks = 0;
+    };
+
+    // Snapshot of the pool's counters. The histograms are HDR-style
+    // log2 buckets over nanoseconds: bucket i counts samples whose bit
+    // width is i, i.e. values in [2^(i-1), 2^i). queueWaitNs measures
+    // submission to dequeue, runTimeNs the task body itself.
+    struct Stats {
+        std::vector<WorkerStats> workers;
+        std::size_t queueDepth = 0;
+        std::array<std::uint64_t, kHistogramBuckets> queueWaitNs{};
+        std::array<std::uint64_t, kHistogramBuckets> runTimeNs{};
+    };
+
+    // Relaxed snapshot — counters from concurrently running workers may
+    // be mid-update, which is fine for monitoring.
+    Stats stats() const;
+
+    // Machine topology, scanned from sysfs once per process. Callers
+    // can size per-node data (e.g. matrix row panels) from this and
+    // then place the work with enqueueOn().
+    static const std::vector<NumaNode>& topology();
+
+    std::size_t numaNodeCount() const;
+    // Node a worker's CPU belongs to; workers are dealt across nodes
+    // round-robin at construction whether or not they are pinned.
+    std::size_t numaNodeOf(std::size_t workerIndex) const;
+
+    // Places a task on a node-local queue that the node's own workers
+    // drain first. Affinity is a preference, not a fence: a worker with
+    // nothing else to do will take a remote node's task rather than
+    // idle, so no work is ever stranded on a busy socket.
+    template <class Fn, class... Args>
+    auto enqueueOn(std::size_t node, Fn&& fn, Args&&... args)
+        -> std::future<std::invoke_result_t<Fn, Args...>> {
+        using ReturnT = std::invoke_result_t<Fn, Args...>;
+
+        std::promise<ReturnT> promise;
+        std::future<ReturnT> future = promise.get_future();
+        submitOn(node % numaNodeCount(),
+                 makeTask<ReturnT>(std::move(promise), std::forward<Fn>(fn),
+                                   std::forward<Args>(args)...));
+        return future;
+    }
+
+    // Lock-free submission through the bounded ring: returns false when
+    // the ring is full (shed load upstream) and throws once shutdown
+    // has started. Fire-and-forget — pair the callable with a promise
+    // or TaskGroup if completion matters. On a pool configured without
+    // boundedQueueCapacity this falls back to a normal enqueue and
+    // always returns true.
+    template <class Fn>
+    bool tryEnqueue(Fn&& fn) {
+        return tryEnqueueTask(TaskFunc(std::forward<Fn>(fn)));
+    }
+
+    // Coroutine hop: `co_await pool.schedule()` suspends the current
+    // coroutine and resumes it on a pool worker. This is how a Task gets
+    // onto the pool — awaiting a Task runs it inline on whatever thread
+    // awaits it until the task itself schedules.
+    auto schedule(Priority priority = Priority::Normal) {
+        struct Awaiter {
+            ThreadPool& pool;
+            Priority priority;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) {
+                pool.submit(TaskFunc([handle]() { handle.resume(); }), priority);
+            }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this, priority};
+    }
+
 private:
-    void workerLoop();
+    friend class TaskGroup;
+    friend class TaskGraph;
+
+    struct Worker;
+    class BoundedQueue;
+
+    // Queue element: the task plus its submission timestamp (0 when
+    // stats are compiled out, so no clock call is made).
+    struct Queued {
+        TaskFunc fn;
+        std::uint64_t enqueueNs = 0;
+    };
+
+    // Iterates a range for the bulk entry points, moving elements out
+    // when the range itself was passed as an rvalue. Range-for alone
+    // always yields lvalues — rvalue-ness of the range does not reach
+    // the elements — so move-only callables need the explicit
+    // std::move(*it) path.
+    template <class Range, class Consume>
+    static void consumeRange(Range&& range, Consume consume) {
+        if constexpr (std::is_lvalue_reference_v<Range>) {
+            for (auto&& fn : range) {
+                consume(fn);
+            }
+        } else {
+            for (auto it = std::begin(range); it != std::end(range); ++it) {
+                consume(std::move(*it));
+            }
+        }
+    }
+
+    // Wraps callable, arguments and promise into one task; the result or
+    // exception lands in the promise.
+    template <class ReturnT, class Fn, class... Args>
+    static TaskFunc makeTask(std::promise<ReturnT> promise, Fn&& fn, Args&&... args) {
+        return TaskFunc(
+            [p = std::move(promise), f = std::decay_t<Fn>(std::forward<Fn>(fn)),
+             tup = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                try {
+                    if constexpr (std::is_void_v<ReturnT>) {
+                        std::apply(f, std::move(tup));
+                        p.set_value();
+                    } else {
+                        p.set_value(std::apply(f, std::move(tup)));
+                    }
+                } catch (...) {
+                    p.set_exception(std::current_exception());
+                }
+            });
+    }
+
+    // Routes a task to the calling worker's deque when invoked from
+    // inside the pool (High/Normal only), or to the global queue for its
+    // priority otherwise. Throws std::runtime_error once shutdown has
+    // started.
+    void submit(TaskFunc task, Priority priority);
+    void submitBulk(std::vector<TaskFunc> tasks, Priority priority = Priority::Normal);
+    void submitOn(std::size_t node, TaskFunc task);
+    bool tryEnqueueTask(TaskFunc task);
+
+    void workerLoop(std::size_t index);
+    bool findTask(std::size_t index, Queued& out);
+    // Starts (or restarts, for a retired slot) the thread for a worker
+    // and applies its CPU pin. Caller holds mutex_ except during
+    // construction.
+    void spawnWorkerThread(std::size_t index);
+    void scalerLoop();
+    // Runs a claimed task, recording queue wait and run time when stats
+    // are enabled.
+    void runQueued(std::size_t index, Queued item);
+    void notifyOne();
+    void notifyMany(std::size_t count);
 
-    std::vector<std::thread> workers_;
-    std::queue<std::function<void()>> tasks_;
+    // Support for the blocking-join primitives: picks a grain when the
+    // caller passed 0, fans out one claiming task per worker, and spins
+    // down a counter by executing pool tasks (when called on a worker)
+    // or waiting on the atomic.
+    void resolveGrain(std::size_t begin, std::size_t end, std::size_t& grain) const;
+    void helpWhile(std::atomic<std::size_t>& remaining);
+
+    template <class Fn>
+    void spawnStripTasks(std::size_t chunks, const Fn& fn) {
+        const std::size_t helpers =
+            std::min(size(), chunks == 0 ? std::size_t{0} : chunks - 1);
+        if (helpers == 0) {
+            return;
+        }
+        std::vector<TaskFunc> batch;
+        batch.reserve(helpers);
+        for (std::size_t i = 0; i < helpers; ++i) {
+            batch.emplace_back(fn);
+        }
+        submitBulk(std::move(batch));
+    }
+
+    // Both vectors have maxWorkers_ capacity reserved up front so they
+    // never reallocate: lock-free readers index workers_ up to
+    // liveWorkers_ while resize() appends under mutex_.
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+    std::vector<std::size_t> workerNode_;
+    std::vector<int> workerCpu_;
+    bool pinWorkers_ = false;
+    std::size_t maxWorkers_ = 0;
+    std::size_t minWorkers_ = 1;
+    std::thread scaler_;
+    // Desired worker count (size(), retirement checks) and the number
+    // of constructed Worker slots (bounds lock-free stealing).
+    std::atomic<std::size_t> targetWorkers_{0};
+    std::atomic<std::size_t> liveWorkers_{0};
+    // One locked queue per priority class, drained High-first; see the
+    // Priority doc for the aging rule that keeps Background alive.
+    std::array<std::queue<Queued>, 3> global_;
+    // One locked queue per NUMA node for enqueueOn placement; a node's
+    // own workers check theirs before the priority queues, everyone
+    // else only as a last resort.
+    std::vector<std::queue<Queued>> nodeQueues_;
+    // Bounded lock-free ring for tryEnqueue; null unless configured.
+    std::unique_ptr<BoundedQueue> bounded_;
+    std::size_t drainCounter_ = 0;  // guarded by mutex_
     mutable std::mutex mutex_;
     std::condition_variable cv_;
-    bool stop_ = false;
+    std::atomic<bool> stop_{false};
+    // Tasks submitted but not yet claimed by a worker; lets sleepers wait
+    // on one counter instead of scanning every deque.
+    std::atomic<std::size_t> pending_{0};
+    // Wakeup elision state: workers spin briefly before parking, and a
+    // producer skips the mutex+notify when a spinner is live (it will
+    // see pending_) or nobody is parked. All four sides of the
+    // handshake use seq_cst so a wakeup cannot be lost; see notifyOne.
+    std::atomic<std::size_t> spinners_{0};
+    std::atomic<std::size_t> sleepers_{0};
+
+    static thread_local ThreadPool* currentPool_;
+    static thread_local std::size_t currentIndex_;
+};
+
+// Counted fan-out/fan-in: spawn() bumps an atomic and submits, wait()
+// blocks once until the count drains. A 10k-task fan-in costs one wait
+// on one counter instead of a shared state allocation and a get() per
+// task, which is what a vector of enqueue() futures costs. Callers that
+// wait from inside a worker help execute pool tasks instead of
+// sleeping, so a task may spawn into a group and wait on it without
+// deadlocking. The first exception out of a spawned task is rethrown
+// from wait(); the rest of the group still runs. Not reusable across
+// threads without external ordering: spawn() and wait() race only in
+// the sense that wait() joins whatever was spawned before it returns.
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& pool) : pool_(pool) {}
+
+    // Joins outstanding tasks; exceptions are swallowed here, so call
+    // wait() yourself if you care about them.
+    ~TaskGroup() { pool_.helpWhile(remaining_); }
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    template <class Fn>
+    void spawn(Fn&& fn, ThreadPool::Priority priority = ThreadPool::Priority::Normal) {
+        remaining_.fetch_add(1, std::memory_order_relaxed);
+        try {
+            pool_.submit(TaskFunc([this, f = std::decay_t<Fn>(std::forward<Fn>(fn))]() mutable {
+                             try {
+                                 f();
+                             } catch (...) {
+                                 std::lock_guard<std::mutex> lock(errorMutex_);
+                                 if (!error_) {
+                                     error_ = std::current_exception();
+                                 }
+                             }
+                             finishOne();
+                         }),
+                         priority);
+        } catch (...) {
+            // submit() threw (pool stopping): the task never made it in.
+            finishOne();
+            throw;
+        }
+    }
+
+    // Blocks until every spawned task has finished, then rethrows the
+    // first captured exception, if any. The group is empty afterwards
+    // and may be reused.
+    void wait() {
+        pool_.helpWhile(remaining_);
+        std::lock_guard<std::mutex> lock(errorMutex_);
+        if (error_) {
+            std::exception_ptr error = std::exchange(error_, nullptr);
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    void finishOne() {
+        if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            remaining_.notify_all();
+        }
+    }
+
+    ThreadPool& pool_;
+    std::atomic<std::size_t> remaining_{0};
+    std::mutex errorMutex_;
+    std::exception_ptr error_;
+};
+
+// Dependency-driven execution of a task DAG, entirely inside the pool:
+// each node carries an atomic in-degree, finishing a node decrements
+// its successors, and a node is submitted the moment its count hits
+// zero — no blocked threads and no lock per edge. Build the graph
+// single-threaded with add()/addEdge(), then run() once; wait() joins
+// with the same helping scheme as TaskGroup. After the first node
+// throws, nodes that have not started are skipped (their bookkeeping
+// still runs, so wait() returns) and the exception is rethrown from
+// wait(). One-shot: a graph that has run cannot run again.
+class TaskGraph {
+public:
+    using NodeId = std::size_t;
+
+    explicit TaskGraph(ThreadPool& pool);
+    ~TaskGraph();  // joins outstanding nodes
+
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    template <class Fn>
+    NodeId add(Fn&& fn, ThreadPool::Priority priority = ThreadPool::Priority::Normal) {
+        return addNode(TaskFunc(std::forward<Fn>(fn)), priority);
+    }
+
+    // Convenience for the common "node after these nodes" shape.
+    template <class Fn>
+    NodeId add(Fn&& fn, std::initializer_list<NodeId> deps,
+               ThreadPool::Priority priority = ThreadPool::Priority::Normal) {
+        const NodeId id = addNode(TaskFunc(std::forward<Fn>(fn)), priority);
+        for (NodeId dep : deps) {
+            addEdge(dep, id);
+        }
+        return id;
+    }
+
+    // `to` becomes runnable only after `from` has finished.
+    void addEdge(NodeId from, NodeId to);
+
+    void run();
+    void wait();
+
+private:
+    struct Node;
+
+    NodeId addNode(TaskFunc fn, ThreadPool::Priority priority);
+    void runNode(NodeId id);
+
+    ThreadPool& pool_;
+    std::vector<std::unique_ptr<Node>> nodes_;
+    std::atomic<std::size_t> remaining_{0};
+    std::atomic<bool> failed_{false};
+    bool started_ = false;
+    std::mutex errorMutex_;
+    std::exception_ptr error_;
+};
+
+namespace detail {
+
+// Result slot shared by Task's promise: value-returning tasks get
+// return_value, void tasks get return_void.
+template <class T>
+struct TaskPromiseStorage {
+    std::optional<T> value;
+    std::exception_ptr error;
+
+    template <class U>
+    void return_value(U&& v) {
+        value.emplace(std::forward<U>(v));
+    }
+    void unhandled_exception() { error = std::current_exception(); }
+    T take() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return std::move(*value);
+    }
 };
+
+template <>
+struct TaskPromiseStorage<void> {
+    std::exception_ptr error;
+
+    void return_void() {}
+    void unhandled_exception() { error = std::current_exception(); }
+    void take() {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+}  // namespace detail
+
+// Lazy, move-only coroutine task. Awaiting one starts it inline on the
+// awaiting thread and suspends the awaiter; when the task finishes, its
+// final suspend resumes the awaiter by symmetric transfer — no handle
+// goes back through the pool's mutex and no worker blocks at the
+// dependency edge, unlike chaining futures through enqueue(). A task
+// hops onto a pool worker by `co_await pool.schedule()`. One-shot:
+// co_await an rvalue, or drive it from plain code with syncWait().
+template <class T = void>
+class Task {
+public:
+    struct promise_type : detail::TaskPromiseStorage<T> {
+        std::coroutine_handle<> continuation;
+
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        auto final_suspend() noexcept {
+            struct FinalAwaiter {
+                bool await_ready() const noexcept { return false; }
+                std::coroutine_handle<> await_suspend(
+                    std::coroutine_handle<promise_type> h) const noexcept {
+                    std::coroutine_handle<> next = h.promise().continuation;
+                    return next ? next : std::noop_coroutine();
+                }
+                void await_resume() const noexcept {}
+            };
+            return FinalAwaiter{};
+        }
+    };
+
+    Task() noexcept = default;
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+                handle.promise().continuation = caller;
+                return handle;  // symmetric transfer: run the child inline
+            }
+            T await_resume() { return handle.promise().take(); }
+        };
+        return Awaiter{handle_};
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+// Minimal eager-after-resume coroutine used by syncWait to bridge into
+// coroutine land; its final suspend flips the caller's flag.
+struct SyncWaitTask {
+    struct promise_type {
+        std::atomic<bool>* done = nullptr;
+
+        SyncWaitTask get_return_object() {
+            return SyncWaitTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        auto final_suspend() noexcept {
+            struct Signal {
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<promise_type> h) const noexcept {
+                    std::atomic<bool>* done = h.promise().done;
+                    done->store(true, std::memory_order_release);
+                    done->notify_all();
+                }
+                void await_resume() const noexcept {}
+            };
+            return Signal{};
+        }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }  // body catches everything
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+struct VoidResult {};
+
+// Bridge coroutine for syncWait. It deliberately takes its inputs as
+// parameters, not lambda captures: parameters are moved into the
+// coroutine frame, whereas a capturing lambda's closure would be a
+// temporary destroyed at the end of the calling statement, leaving the
+// frame reading dead stack on resume.
+template <class T, class Value>
+SyncWaitTask runSyncWait(Task<T> task, std::exception_ptr* error,
+                         Value* value) {
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await std::move(task);
+        } else {
+            value->emplace(co_await std::move(task));
+        }
+    } catch (...) {
+        *error = std::current_exception();
+    }
+}
+
+}  // namespace detail
+
+// Drives a Task from non-coroutine code: starts it on the calling
+// thread and blocks until it completes, then returns its value or
+// rethrows its exception. The wait is a plain atomic block — do not
+// call this from inside a pool worker (it would idle the worker; await
+// the task from a coroutine instead).
+template <class T>
+T syncWait(Task<T> task) {
+    std::atomic<bool> done{false};
+    std::exception_ptr error;
+    std::optional<std::conditional_t<std::is_void_v<T>, detail::VoidResult, T>> value;
+
+    detail::SyncWaitTask runner =
+        detail::runSyncWait(std::move(task), &error, &value);
+    runner.handle.promise().done = &done;
+    runner.handle.resume();
+    while (!done.load(std::memory_order_acquire)) {
+        done.wait(false, std::memory_order_acquire);
+    }
+    runner.handle.destroy();
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    if constexpr (!std::is_void_v<T>) {
+        return std::move(*value);
+    }
+}